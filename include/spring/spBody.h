@@ -3,6 +3,7 @@
 #define SP_BODY_H
 
 #include "spLinkedList.h"
+#include "spBound.h"
 #include "spMath.h"
 
 /// @defgroup spBody spBody
@@ -24,6 +25,7 @@ struct spBody
     spTransform xf;            ///< rigid body transform 
     spVector com;              ///< center of mass in local 
     spVector p;                ///< position of the com in world space
+    spVector p0;               ///< position of the com at the start of the last position integration
     spVector f;                ///< force to be applied to the body during integration
     spVector v;                ///< linear velocity
     spFloat gScale;            ///< gravity scale on this rigid body
@@ -35,11 +37,17 @@ struct spBody
     spFloat m;                 ///< mass
     spFloat t;                 ///< torque to be applied to the body during integration
     spFloat a;                 ///< rotation angle around com in world space
+    spFloat a0;                ///< rotation angle at the start of the last position integration
     spFloat w;                 ///< angular velocity
+    spFloat sleepTime;         ///< how long the body has been moving slower than the sleep tolerances
     spBody* next;              ///< the next body in the linked list of bodies
     spBody* prev;              ///< the previous body in the linked list of bodies
     spBodyType type;           ///< the type of the body, which describes how it is simulated
+    spBool bullet;             ///< spTrue if the body is swept against other shapes each step so it cannot tunnel
+    spBool awake;              ///< spTrue if the body is simulated, sleeping bodies are skipped until something wakes them
+    spInt islandNode;          ///< index of the body in the worlds island graph, -1 if the body is not dynamic
     spShape* shapes;           ///< shapes attached to a body
+    spAABB aabb;               ///< union of the fat aabbs of the bodys shapes, kept up to date by the world
     spWorld* world;            ///< world the body is in
     spLazyPointer userData;    ///< user data pointer
 };
@@ -92,6 +100,9 @@ SPRING_API void spBodyIntegrateVelocity(spBody* body, const spVector gravity, co
 /// integrates velocity and updates position - semi-implicit euler
 SPRING_API void spBodyIntegratePosition(spBody* body, const spFloat h);
 
+/// update the transform and the world space shape data after the com position or angle were changed directly
+SPRING_API void spBodyUpdateTransform(spBody* body);
+
 /// calculates a bodies acceleration given gravity
 SPRING_API spVector spBodyAcceleration(spBody* body, const spVector gravity);
 
@@ -125,6 +136,9 @@ SPRING_API void spBodyApplyImpulseAtPoint(spBody* body, spVector point, spVector
 /// apply an impulse to the body given the rel velocity to a point and an impulse
 SPRING_API void spBodyApplyImpulse(spBody* body, spVector relVelocity, spVector impulse);
 
+/// apply an angular impulse to the body
+SPRING_API void spBodyApplyAngularImpulse(spBody* body, spFloat impulse);
+
 /// get the body's transform
 SPRING_API spTransform spBodyGetTransform(spBody* body);
 
@@ -170,6 +184,12 @@ SPRING_API spBody* spBodyGetPrev(spBody* body);
 /// get the body's type
 SPRING_API spBodyType spBodyGetType(spBody* body);
 
+/// check if the body is a bullet
+SPRING_API spBool spBodyIsBullet(spBody* body);
+
+/// check if the body is awake
+SPRING_API spBool spBodyIsAwake(spBody* body);
+
 /// get the body's shape list
 SPRING_API spShape* spBodyGetShapeList(spBody* body);
 
@@ -220,6 +240,17 @@ SPRING_API void spBodySetMass(spBody* body, spFloat mass);
 /// sets the body type, resets custom mass data to shapes mass data
 SPRING_API void spBodySetType(spBody* body, spBodyType type);
 
+/// make the body a bullet. bullets are swept from their old to their new position every step, and are stopped
+/// at the first shape they would hit. shapes of bodies that moved this step are swept along their own path too, and
+/// a dynamic body that is hit is stopped at the impact with the bullet. use it for small fast bodies that would
+/// otherwise tunnel through walls or other fast bodies
+SPRING_API void spBodySetBullet(spBody* body, spBool bullet);
+
+/// wake the body up or put it to sleep. a sleeping body has no velocity, and is not moved or collided until
+/// it is woken. the world wakes bodies when they are moved, pushed, or touched by an awake body, and puts
+/// them back to sleep once their whole island has been still for a while. static bodies are never awake
+SPRING_API void spBodySetAwake(spBody* body, spBool awake);
+
 /// sets the body's user data pointer
 SPRING_API void spBodySetUserData(spBody* body, spLazyPointer* data);
 
@@ -15,6 +15,13 @@ struct spBound
     spFloat  radius;    ///< radius of circle
 };
 
+/// 2d axis aligned bounding box in world space, used by the broadphase
+struct spAABB
+{
+    spVector min; ///< lower bound of the box
+    spVector max; ///< upper bound of the box
+};
+
 /// initialize the bound
 SPRING_API void spBoundInit(spBound* bound, spVector center, spFloat radius);
 
@@ -54,6 +61,54 @@ SPRING_API void spBoundSetCenter(spBound* bound, spVector center);
 /// set the bounds radius
 SPRING_API void spBoundSetRadius(spBound* bound, spFloat radius);
 
+/// get the bounding box in world space as an aabb
+SPRING_API spAABB spBoundGetWorldAABB(spBound* bound, spTransform* xf);
+
+/// stack constructor
+INLINE spAABB spAABBConstruct(const spVector min, const spVector max)
+{
+    spAABB aabb;
+    aabb.min = min;
+    aabb.max = max;
+    return aabb;
+}
+
+/// check if two aabbs overlap
+INLINE spBool spAABBOverlap(const spAABB* a, const spAABB* b)
+{
+    if (a->max.x < b->min.x || a->min.x > b->max.x) return spFalse;
+    if (a->max.y < b->min.y || a->min.y > b->max.y) return spFalse;
+    return spTrue;
+}
+
+/// check if aabb a fully contains aabb b
+INLINE spBool spAABBContains(const spAABB* a, const spAABB* b)
+{
+    return a->min.x <= b->min.x && a->min.y <= b->min.y &&
+           b->max.x <= a->max.x && b->max.y <= a->max.y;
+}
+
+/// get the smallest aabb that contains both a and b
+INLINE spAABB spAABBUnion(const spAABB* a, const spAABB* b)
+{
+    return spAABBConstruct(
+        spVectorConstruct(spMin(a->min.x, b->min.x), spMin(a->min.y, b->min.y)),
+        spVectorConstruct(spMax(a->max.x, b->max.x), spMax(a->max.y, b->max.y)));
+}
+
+/// get the perimeter of an aabb, used as the 2d 'surface area' cost
+INLINE spFloat spAABBPerimeter(const spAABB* a)
+{
+    return 2.0f * ((a->max.x - a->min.x) + (a->max.y - a->min.y));
+}
+
+/// get an aabb enlarged by a margin on each side
+INLINE spAABB spAABBFatten(const spAABB* a, const spFloat margin)
+{
+    spVector r = spVectorConstruct(margin, margin);
+    return spAABBConstruct(spvSub(a->min, r), spvAdd(a->max, r));
+}
+
 /// @}
 
 #endif
\ No newline at end of file
@@ -0,0 +1,153 @@
+#ifndef SP_BROAD_PHASE_H
+#define SP_BROAD_PHASE_H
+
+#include "spSweepAndPrune.h"
+#include "spDynamicTree.h"
+#include "spSpatialHash.h"
+
+/// @defgroup spBroadPhase spBroadPhase
+/// @{
+
+/// broadphase algorithms the world can use to find potentially colliding pairs
+typedef enum
+{
+    SP_BROADPHASE_BRUTE_FORCE = 0, ///< test every shape against every other shape
+    SP_BROADPHASE_SAP = 1,         ///< sweep and prune
+    SP_BROADPHASE_TREE = 2,        ///< dynamic aabb tree
+    SP_BROADPHASE_GRID = 3,        ///< uniform spatial hash grid
+    SP_BROADPHASE_CUSTOM = 4,      ///< user implemented broadphase
+} spBroadPhaseType;
+
+/// called when the proxies of two shapes start or stop overlapping
+typedef void (*spBroadPhasePairCallback)(spLazyPointer context, spShape* shapeA, spShape* shapeB);
+
+/// called for each shape whose proxy overlaps a query box. return spFalse to stop the query
+typedef spBool (*spBroadPhaseQueryCallback)(spLazyPointer context, spShape* shape);
+
+typedef void   (*spBroadPhaseFreeFunc)(spBroadPhase** broadPhase);
+typedef spInt  (*spBroadPhaseInsertFunc)(spBroadPhase* broadPhase, spShape* shape, const spAABB* aabb);
+typedef void   (*spBroadPhaseRemoveFunc)(spBroadPhase* broadPhase, spInt proxyId);
+typedef void   (*spBroadPhaseMoveFunc)(spBroadPhase* broadPhase, spInt proxyId, const spAABB* aabb);
+typedef void   (*spBroadPhaseUpdatePairsFunc)(spBroadPhase* broadPhase, spBroadPhasePairCallback addPair, spBroadPhasePairCallback removePair, spLazyPointer context);
+typedef void   (*spBroadPhaseQueryFunc)(spBroadPhase* broadPhase, const spAABB* aabb, spBroadPhaseQueryCallback func, spLazyPointer context);
+typedef spBool (*spBroadPhaseTestOverlapFunc)(spBroadPhase* broadPhase, spInt proxyA, spInt proxyB);
+
+/// broadphase function pointers
+struct spBroadPhaseFuncs
+{
+    spBroadPhaseFreeFunc        free;        ///< release the broadphase and all of its proxies
+    spBroadPhaseInsertFunc      insert;      ///< insert a shapes proxy given its fat world aabb, returns the proxy id
+    spBroadPhaseRemoveFunc      remove;      ///< remove a proxy
+    spBroadPhaseMoveFunc        move;        ///< move a proxy to a new fat world aabb, only called when the shape left its old one
+    spBroadPhaseUpdatePairsFunc updatePairs; ///< report pairs that started (and optionally stopped) overlapping
+    spBroadPhaseQueryFunc       query;       ///< find every shape whose proxy overlaps an aabb
+    spBroadPhaseTestOverlapFunc testOverlap; ///< check if two proxies still overlap, contacts live while this is true
+};
+
+/// a broadphase finds pairs of shapes whose bounds overlap. every implementation
+/// embeds this as its first member so it can be cast to and from the base
+struct spBroadPhase
+{
+    spBroadPhaseFuncs funcs; ///< broadphase functions (insert, move, etc...)
+    spBroadPhaseType type;   ///< the broadphase type
+};
+
+/// a proxy in the brute force broadphase
+struct spBruteForceProxy
+{
+    spAABB aabb;     ///< world aabb of the proxy
+    spShape* shape;  ///< the shape, NULL if the proxy is not in use
+    spInt next;      ///< next free proxy
+};
+
+/// tests every body against every other body each step, and only tests the
+/// proxies of two bodies against each other if the bodies aabbs overlap
+struct spBruteForce
+{
+    spBroadPhase broadPhase;    ///< base broadphase class
+    spBruteForceProxy* proxies; ///< proxy pool
+    spBody** bodies;            ///< scratch list of the bodies that own proxies
+    spInt capacity;             ///< size of the proxy pool
+    spInt bodyCapacity;         ///< size of the body list
+    spInt freeList;             ///< first free proxy
+};
+
+/// sweep and prune broadphase
+struct spSapBroadPhase
+{
+    spBroadPhase broadPhase; ///< base broadphase class
+    spSap sap;               ///< the sweep and prune structure
+};
+
+/// dynamic aabb tree broadphase
+struct spTreeBroadPhase
+{
+    spBroadPhase broadPhase; ///< base broadphase class
+    spDynamicTree tree;      ///< the dynamic tree
+};
+
+/// spatial hash grid broadphase
+struct spGridBroadPhase
+{
+    spBroadPhase broadPhase; ///< base broadphase class
+    spSpatialHash grid;      ///< the spatial hash grid
+};
+
+/// initialize broadphase function pointers
+SPRING_API void spBroadPhaseInitFuncs(spBroadPhaseFuncs* funcs, spBroadPhaseFreeFunc free, spBroadPhaseInsertFunc insert, spBroadPhaseRemoveFunc remove,
+                                      spBroadPhaseMoveFunc move, spBroadPhaseUpdatePairsFunc updatePairs, spBroadPhaseQueryFunc query, spBroadPhaseTestOverlapFunc testOverlap);
+
+/// initialize the base of a broadphase implementation
+SPRING_API void spBroadPhaseInit(spBroadPhase* broadPhase, spBroadPhaseType type);
+
+/// create one of the built in broadphases on the heap, the grid uses the default cell size
+SPRING_API spBroadPhase* spBroadPhaseNew(spBroadPhaseType type);
+
+/// create a brute force broadphase on the heap
+SPRING_API spBroadPhase* spBruteForceNew();
+
+/// create a sweep and prune broadphase on the heap
+SPRING_API spBroadPhase* spSapBroadPhaseNew();
+
+/// create a dynamic aabb tree broadphase on the heap
+SPRING_API spBroadPhase* spTreeBroadPhaseNew();
+
+/// create a spatial hash grid broadphase on the heap given a cell size
+SPRING_API spBroadPhase* spGridBroadPhaseNew(spFloat cellSize);
+
+/// release a broadphase from the heap
+SPRING_API void spBroadPhaseFree(spBroadPhase** broadPhase);
+
+/// insert a shapes proxy given its fat world aabb, returns the proxy id
+SPRING_API spInt spBroadPhaseInsert(spBroadPhase* broadPhase, spShape* shape, const spAABB* aabb);
+
+/// remove a proxy from the broadphase
+SPRING_API void spBroadPhaseRemove(spBroadPhase* broadPhase, spInt proxyId);
+
+/// move a proxy to a new fat world aabb
+SPRING_API void spBroadPhaseMove(spBroadPhase* broadPhase, spInt proxyId, const spAABB* aabb);
+
+/// report pairs that started overlapping to addPair. removePair may be called for pairs that stopped overlapping
+SPRING_API void spBroadPhaseUpdatePairs(spBroadPhase* broadPhase, spBroadPhasePairCallback addPair, spBroadPhasePairCallback removePair, spLazyPointer context);
+
+/// query the broadphase for every shape whose proxy overlaps an aabb
+SPRING_API void spBroadPhaseQuery(spBroadPhase* broadPhase, const spAABB* aabb, spBroadPhaseQueryCallback func, spLazyPointer context);
+
+/// check if two proxies overlap
+SPRING_API spBool spBroadPhaseTestOverlap(spBroadPhase* broadPhase, spInt proxyA, spInt proxyB);
+
+/// get the broadphase type
+SPRING_API spBroadPhaseType spBroadPhaseGetType(spBroadPhase* broadPhase);
+
+/// safely cast a broadphase to a sweep and prune broadphase if its that type
+SPRING_API spSapBroadPhase* spBroadPhaseCastSap(spBroadPhase* broadPhase);
+
+/// safely cast a broadphase to a tree broadphase if its that type
+SPRING_API spTreeBroadPhase* spBroadPhaseCastTree(spBroadPhase* broadPhase);
+
+/// safely cast a broadphase to a grid broadphase if its that type
+SPRING_API spGridBroadPhase* spBroadPhaseCastGrid(spBroadPhase* broadPhase);
+
+/// @}
+
+#endif
@@ -34,6 +34,9 @@ SPRING_API void spCircleFree(spShape** circle);
 /// tests if a point is inside of the circle
 SPRING_API spBool spCircleTestPoint(spCircle* circle, spVector point);
 
+/// compute the circles tight aabb in world space
+SPRING_API spAABB spCircleComputeAABB(spCircle* circle);
+
 /// gets the center in the circles local space
 SPRING_API spVector spCircleGetLocalCenter(spCircle* circle);
 
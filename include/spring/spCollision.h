@@ -7,6 +7,14 @@
 /// @defgroup spCollision spCollision
 /// @{
 
+/// a vertex or edge of a shape, the features a contact point came from
+#define SP_FEATURE_VERTEX(index) ((spUint)(index) & 0x7fffu)
+#define SP_FEATURE_EDGE(index)   (((spUint)(index) & 0x7fffu) | 0x8000u)
+
+/// identifies a contact point by the feature of shape a and the feature of shape b that produced it.
+/// points with the same id in two steps are the same point, and keep their accumulated impulses
+#define SP_FEATURE_ID(featureA, featureB) ((spUint)(featureA) | ((spUint)(featureB) << 16))
+
 /// tells you information on two shapes contact information, returned by collision functions
 struct spCollisionResult
 {
@@ -14,16 +22,56 @@ struct spCollisionResult
     spVector normal;    ///< collision normal
     spVector pointA[2]; ///< collision points, for body A
     spVector pointB[2]; ///< collision points, for body B
+    spUint   id[2];     ///< feature id of each collision point
     spInt    count;     ///< number of contact points
 };
 
+/// polygons with at least this many vertices find support points by walking from the last one instead of testing every vertex
+#define SP_HILL_CLIMB_VERTICES 12
+
+/// polygons with a radius larger than this are treated as rounded shapes, and collide through gjk/epa instead of sat
+#define SP_SAT_MAX_RADIUS 0.5f
+
+/// collision state a contact keeps between steps. the support directions of the last simplex edge
+/// are used to seed gjk the next step, so resting pairs converge in one or two iterations. sat keeps
+/// the last separating axis, so pairs that are still apart are rejected after testing a single axis
+struct spCollisionCache
+{
+    spVector dirs[2]; ///< support directions of the two points of the last simplex edge
+    spInt iterations; ///< gjk iterations used the last time the pair was collided
+    spInt support[2]; ///< last support vertex of each shape, where hill climbing starts
+    spInt axisShape;  ///< shape that owns the last separating axis, 0 for shape a, 1 for shape b
+    spInt axisEdge;   ///< edge normal that was the last separating axis, -1 if the shapes overlapped
+    spBool valid;     ///< spTrue if the directions can be used to seed gjk
+    spVector origins[2]; ///< body positions when the separation was measured
+    spFloat angles[2];   ///< body angles when the separation was measured
+    spFloat separation;  ///< lower bound on the gap between the shapes when it was measured, 0 if they were touching
+    spFloat margin;      ///< shapes closer than this are treated as touching, and get contact points that are still apart
+    spBool sat;          ///< spTrue if polygons collide with sat, otherwise with gjk/epa. rounded polygons always use gjk/epa
+};
+
 /// collision/support function pointer typedefs
-typedef struct spCollisionResult (*spCollisionFunc)(const struct spShape* shapeA, const struct spShape* shapeB);
-typedef struct spVector (*SupportPointFunc)(const struct spShape* shapeA, const spVector normal);
+typedef struct spCollisionResult (*spCollisionFunc)(const struct spShape* shapeA, const struct spShape* shapeB, struct spCollisionCache* cache);
+typedef struct spVector (*SupportPointFunc)(const struct spShape* shapeA, const spVector normal, spInt* hint);
 
-/// list of collision functions, indexed by the shapes types
+/// list of collision functions, indexed by the shapes types. polygon pairs use sat, spCollide picks gjk/epa per call from the cache
 extern spCollisionFunc CollideFunc[SP_SHAPE_COUNT][SP_SHAPE_COUNT];
 
+/// collide two shapes with CollideFunc, unless they are clearly apart. the collision function is skipped when
+/// the shapes bounding circles do not overlap, or when the bodies have not moved far enough since the gap
+/// cached by an earlier call was measured to close it
+SPRING_API spCollisionResult spCollide(const spShape* shapeA, const spShape* shapeB, spCollisionCache* cache);
+
+/// get a lower bound on the distance between two shapes, 0 if they are touching. the margin of the cache is ignored
+SPRING_API spFloat spCollisionDistance(const spShape* shapeA, const spShape* shapeB, spCollisionCache* cache);
+
+/// collide a batch of circle/circle contacts, four pairs at a time when simd is available.
+/// indices are the contacts to collide, the result of contacts[indices[i]] is written to results[indices[i]]
+SPRING_API void spCollideCircleBatch(const spContact* contacts, const spInt* indices, spInt count, spCollisionResult* results);
+
+/// initialize an empty collision cache, gjk will seed itself from the shapes centers of mass. polygons collide with sat
+SPRING_API void spCollisionCacheInit(spCollisionCache* cache);
+
 /// @}
 
 #endif
\ No newline at end of file
@@ -3,6 +3,7 @@
 #define SP_CONTACT_H
 
 #include "spContactKey.h"
+#include "spCollision.h"
 #include "spMath.h"
 
 /// @defgroup spContact spContact
@@ -29,6 +30,7 @@ struct spContactPoint
     spFloat lambdaAccumTang; ///< accumulated tangent impulse multiplier
     spFloat bounce;          ///< bounce bias based on restitution
     spFloat bias;            ///< baumgarte velocity bias
+    spUint id;               ///< feature id of the point, matched between steps to keep the accumulated impulses
 };
 
 /// a contact that describes contact information between two shapes and how they react
@@ -36,8 +38,7 @@ struct spContact
 {
     spContactPoint points[2]; ///< contact points
     spContactKey key;         ///< contact key containing bodies
-    spContact* next;          ///< next contact in the doubly linked list
-    spContact* prev;          ///< previous contact in the doubly linked list
+    spCollisionCache cache;   ///< collision state from the last step, used to warm start the narrowphase
     spVector normal;          ///< shared contact normal
     spFloat restitution;      ///< 'bounciness' of the contact
     spFloat friction;         ///< friction of the contact
@@ -63,7 +64,7 @@ SPRING_API void spContactFree(spContact** contact);
 /// initialize a constraint for use in the impulse solver
 SPRING_API void spContactPreSolve(spContact* contact, const spFloat h);
 
-/// warm start contacts from last frame
+/// warm start contacts with the impulses accumulated last frame by the points that were matched
 SPRING_API void spContactWarmStart(spContact* contact);
 
 /// calculate and apply an impulse to each body in the contact
@@ -72,12 +73,6 @@ SPRING_API void spContactSolve(spContact* contact);
 /// get the contact key of this contact
 SPRING_API spContactKey spContactGetKey(spContact* contact);
 
-/// get the next contact in the list
-SPRING_API spContact* spContactGetNext(spContact* contact);
-
-/// get the prev contact in the list
-SPRING_API spContact* spContactGetPrev(spContact* contact);
-
 /// get the contact's normal
 SPRING_API spVector spContactGetNormal(spContact* contact);
 
@@ -20,9 +20,6 @@ SPRING_API void spContactKeyInit(spContactKey* key, spShape* shapeA, spShape* sh
 /// 'faked' constructor for stack allocation
 SPRING_API spContactKey spContactKeyConstruct(spShape* shapeA, spShape* shapeB);
 
-/// checks if a contact with a contact key exists
-SPRING_API spBool spContactKeyExists(spContactKey key, spContact* contactList);
-
 /// checks if two contact keys are the same
 SPRING_API spBool spContactKeyEqual(spContactKey keyA, spContactKey keyB);
 
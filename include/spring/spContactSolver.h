@@ -0,0 +1,122 @@
+#ifndef SP_CONTACT_SOLVER_H
+#define SP_CONTACT_SOLVER_H
+
+#include "spContact.h"
+
+/// number of contact constraints packed into a wide constraint, one per sse2 lane
+#define SP_WIDE_LANES 4
+
+/// @defgroup spContactSolver spContactSolver
+/// @{
+
+/// the part of a dynamic body the contact solver reads and writes, copied out of the body before the
+/// contacts are solved and back into it after. bodies are indexed by their island node. the wide solver
+/// loads v, w and mInv as one vector, so they have to stay first and in this order
+struct spSolverBody
+{
+    spVector v;    ///< linear velocity
+    spFloat w;     ///< angular velocity
+    spFloat mInv;  ///< inverse mass
+    spFloat iInv;  ///< inverse inertia
+};
+
+/// a point of a contact constraint
+struct spContactConstraintPoint
+{
+    spVector rA;             ///< contact point relative to body a com
+    spVector rB;             ///< contact point relative to body b com
+    spVector velocity;       ///< relative velocity of the point from the static and kinematic body, which the solver does not move
+    spFloat eMassNorm;       ///< effective normal mass
+    spFloat eMassTang;       ///< effective tangent mass
+    spFloat lambdaAccumNorm; ///< accumulated normal impulse multiplier
+    spFloat lambdaAccumTang; ///< accumulated tangent impulse multiplier
+    spFloat bounce;          ///< bounce bias based on restitution
+    spFloat bias;            ///< baumgarte velocity bias
+};
+
+/// everything the solver needs from a contact, packed so the contacts of an island sit next to each
+/// other and only touch their solver bodies while solving
+struct spContactConstraint
+{
+    spContactConstraintPoint points[2]; ///< constraint points
+    spVector normal;                    ///< shared contact normal
+    spFloat friction;                   ///< friction of the contact
+    spInt indexA;                       ///< solver body of body a, -1 if body a is not dynamic
+    spInt indexB;                       ///< solver body of body b, -1 if body b is not dynamic
+    spInt count;                        ///< number of points
+    spInt contact;                      ///< index of the contact in the worlds contact array
+};
+
+/// a point of a wide contact constraint, each array holds one value per lane
+struct spWideContactPoint
+{
+    spFloat rAx[SP_WIDE_LANES];        ///< contact point relative to body a com, x
+    spFloat rAy[SP_WIDE_LANES];        ///< contact point relative to body a com, y
+    spFloat rBx[SP_WIDE_LANES];        ///< contact point relative to body b com, x
+    spFloat rBy[SP_WIDE_LANES];        ///< contact point relative to body b com, y
+    spFloat vx[SP_WIDE_LANES];         ///< relative velocity from the static and kinematic body, x
+    spFloat vy[SP_WIDE_LANES];         ///< relative velocity from the static and kinematic body, y
+    spFloat eMassNorm[SP_WIDE_LANES];  ///< effective normal mass
+    spFloat eMassTang[SP_WIDE_LANES];  ///< effective tangent mass
+    spFloat lambdaNorm[SP_WIDE_LANES]; ///< accumulated normal impulse multiplier
+    spFloat lambdaTang[SP_WIDE_LANES]; ///< accumulated tangent impulse multiplier
+    spFloat bounce[SP_WIDE_LANES];     ///< bounce bias based on restitution
+    spFloat bias[SP_WIDE_LANES];       ///< baumgarte velocity bias
+};
+
+/// up to SP_WIDE_LANES contact constraints of the same graph color, solved side by side. they share no
+/// dynamic body, so every lane reads and writes its own bodies. lanes without a constraint, and the
+/// second point of constraints with one point, are zeroed so their impulses are always zero
+struct spWideContactConstraint
+{
+    spWideContactPoint points[2];     ///< constraint points
+    spFloat normalX[SP_WIDE_LANES];   ///< shared contact normal, x
+    spFloat normalY[SP_WIDE_LANES];   ///< shared contact normal, y
+    spFloat friction[SP_WIDE_LANES];  ///< friction of the contact
+    spFloat mInvA[SP_WIDE_LANES];     ///< inverse mass of body a
+    spFloat iInvA[SP_WIDE_LANES];     ///< inverse inertia of body a
+    spFloat mInvB[SP_WIDE_LANES];     ///< inverse mass of body b
+    spFloat iInvB[SP_WIDE_LANES];     ///< inverse inertia of body b
+    spInt indexA[SP_WIDE_LANES];      ///< solver body of body a, -1 if body a is not dynamic
+    spInt indexB[SP_WIDE_LANES];      ///< solver body of body b, -1 if body b is not dynamic
+    spInt count;                      ///< number of lanes in use
+    spInt pointCount;                 ///< most points of any lane, lanes with fewer have their last point zeroed
+};
+
+/// check if this build and the cpu it runs on can solve wide constraints with simd. the cpu is asked with cpuid
+SPRING_API spBool spContactSolverHasSIMD();
+
+/// copy the velocity and mass of a dynamic body into its solver body
+SPRING_API void spSolverBodyLoad(spSolverBody* solverBody, spBody* body);
+
+/// copy the velocity of a solver body back into its body
+SPRING_API void spSolverBodyStore(spSolverBody* solverBody, spBody* body);
+
+/// pack a contact that was pre solved into a constraint. index is the contacts index in the worlds contact array
+SPRING_API void spContactConstraintInit(spContactConstraint* constraint, spContact* contact, spInt index);
+
+/// warm start a constraint with the impulses accumulated last frame
+SPRING_API void spContactConstraintWarmStart(spContactConstraint* constraint, spSolverBody* bodies);
+
+/// calculate and apply an impulse to the solver bodies of each point in the constraint
+SPRING_API void spContactConstraintSolve(spContactConstraint* constraint, spSolverBody* bodies);
+
+/// copy the accumulated impulses back into the constraints contact, so they warm start the next step
+SPRING_API void spContactConstraintStore(spContactConstraint* constraint, spContact* contacts);
+
+/// pack count constraints, which must not share a dynamic body, into the lanes of a wide constraint
+SPRING_API void spWideContactConstraintInit(spWideContactConstraint* wide, spContactConstraint* constraints, spInt count, spSolverBody* bodies);
+
+/// warm start every lane of a wide constraint. the impulses match spContactConstraintWarmStart bit for bit
+SPRING_API void spWideContactConstraintWarmStart(spWideContactConstraint* wide, spSolverBody* bodies);
+
+/// solve every lane of a wide constraint with sse2, or one lane at a time without it. the impulses
+/// match spContactConstraintSolve bit for bit
+SPRING_API void spWideContactConstraintSolve(spWideContactConstraint* wide, spSolverBody* bodies);
+
+/// copy the accumulated impulses of each lane back into the constraints the wide constraint was packed from
+SPRING_API void spWideContactConstraintStore(spWideContactConstraint* wide, spContactConstraint* constraints);
+
+/// @}
+
+#endif
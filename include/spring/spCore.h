@@ -80,23 +80,51 @@ typedef struct spMotorJoint         spMotorJoint;
 typedef struct spMouseJoint         spMouseJoint;
 typedef struct spPointJoint         spPointJoint;
 typedef struct spConstraint         spConstraint;
+typedef struct spDynamicTree        spDynamicTree;
+typedef struct spBroadPhaseFuncs    spBroadPhaseFuncs;
+typedef struct spBruteForceProxy    spBruteForceProxy;
+typedef struct spSapBroadPhase      spSapBroadPhase;
+typedef struct spTreeBroadPhase     spTreeBroadPhase;
+typedef struct spGridBroadPhase     spGridBroadPhase;
+typedef struct spBroadPhase         spBroadPhase;
+typedef struct spBruteForce         spBruteForce;
+typedef struct spSpatialHash        spSpatialHash;
 typedef struct spTransform          spTransform;
 typedef struct spRopeJoint          spRopeJoint;
 typedef struct spGearJoint          spGearJoint;
 typedef struct spInterval           spInterval;
+typedef struct spIslandGraph        spIslandGraph;
+typedef struct spIsland             spIsland;
+typedef struct spGraphColoring      spGraphColoring;
+typedef struct spGraphColor         spGraphColor;
 typedef struct spRotation           spRotation;
 typedef struct spMassData           spMassData;
 typedef struct spMaterial           spMaterial;
 typedef struct spSegment            spSegment;
 typedef struct spPolygon            spPolygon;
+typedef struct spPairManager        spPairManager;
 typedef struct spContact            spContact;
+typedef struct spContactConstraint  spContactConstraint;
+typedef struct spContactConstraintPoint spContactConstraintPoint;
+typedef struct spSolverBody         spSolverBody;
+typedef struct spWideContactConstraint spWideContactConstraint;
+typedef struct spWideContactPoint   spWideContactPoint;
 typedef struct spVector             spVector;
 typedef struct spCircle             spCircle;
 typedef struct spMatrix             spMatrix;
+typedef struct spSapEndpoint        spSapEndpoint;
+typedef struct spCollisionCache     spCollisionCache;
 typedef struct spSapBox             spSapBox;
+typedef struct spTreeNode           spTreeNode;
+typedef struct spThreadPool         spThreadPool;
+typedef struct spThreadPoolWorker   spThreadPoolWorker;
+typedef struct spTaskDeque          spTaskDeque;
+typedef struct spGridProxy          spGridProxy;
+typedef struct spGridEntry          spGridEntry;
 typedef struct spFilter             spFilter;
 typedef struct spShape              spShape;
 typedef struct spBound              spBound;
+typedef struct spAABB               spAABB;
 typedef struct spWorld              spWorld;
 typedef struct spEdge               spEdge;
 typedef struct spBody               spBody;
@@ -0,0 +1,90 @@
+#ifndef SP_DYNAMIC_TREE_H
+#define SP_DYNAMIC_TREE_H
+
+#include "spBound.h"
+
+/// @defgroup spDynamicTree spDynamicTree
+/// @{
+
+/// index used for null nodes and invalid proxies
+#define SP_NULL_NODE (-1)
+
+/// margin added to each side of a proxy's aabb. small movements stay inside the fat box and dont touch the tree
+#define SP_AABB_EXTENSION 4.0f
+
+/// a node in the tree. leaves hold the proxies, internal nodes hold the union of their children
+struct spTreeNode
+{
+    spAABB aabb;        ///< fat aabb of a leaf, or the union of the childrens aabbs
+    spLazyPointer data; ///< user data of a leaf (the shape)
+    spInt parent;       ///< parent node, or the next free node if this node is in the free list
+    spInt child1;       ///< first child, SP_NULL_NODE for leaves
+    spInt child2;       ///< second child, SP_NULL_NODE for leaves
+    spInt height;       ///< 0 for leaves, -1 for free nodes
+    spBool moved;       ///< the leaf was reinserted since the last pair update
+};
+
+/// dynamic bounding volume tree broadphase. leaves are fattened aabbs so the tree is only
+/// touched when a proxy leaves its fat box. new leaves are placed with the surface area
+/// heuristic and nodes are rotated on the way back up to keep the tree cheap to query
+struct spDynamicTree
+{
+    spTreeNode* nodes;  ///< node pool
+    spInt* moveBuffer;  ///< proxies that were inserted or reinserted since the last pair update
+    spInt root;         ///< root node of the tree
+    spInt count;        ///< number of allocated nodes
+    spInt capacity;     ///< size of the node pool
+    spInt freeList;     ///< first free node in the pool
+    spInt moveCount;    ///< number of proxies in the move buffer
+    spInt moveCapacity; ///< size of the move buffer
+    spFloat margin;     ///< margin added to each side of a proxy's aabb
+};
+
+/// called for each proxy whose fat aabb overlaps the query box. return spFalse to stop the query
+typedef spBool (*spTreeQueryFunc)(spLazyPointer context, spInt proxyId);
+
+/// called for each new pair of overlapping proxies found during a pair update
+typedef void (*spTreePairFunc)(spLazyPointer context, spLazyPointer dataA, spLazyPointer dataB);
+
+/// initialize an empty tree
+SPRING_API void spDynamicTreeInit(spDynamicTree* tree);
+
+/// construct an empty tree on the stack
+SPRING_API spDynamicTree spDynamicTreeConstruct();
+
+/// release all memory held by the tree
+SPRING_API void spDynamicTreeDestroy(spDynamicTree* tree);
+
+/// insert a proxy into the tree given a tight aabb, returns the proxy id
+SPRING_API spInt spDynamicTreeInsertProxy(spDynamicTree* tree, const spAABB* aabb, spLazyPointer data);
+
+/// remove a proxy from the tree
+SPRING_API void spDynamicTreeRemoveProxy(spDynamicTree* tree, spInt proxyId);
+
+/// move a proxy given its new tight aabb. returns spTrue if the proxy left its fat box and was reinserted
+SPRING_API spBool spDynamicTreeMoveProxy(spDynamicTree* tree, spInt proxyId, const spAABB* aabb);
+
+/// query the tree for all proxies that overlap an aabb
+SPRING_API void spDynamicTreeQuery(spDynamicTree* tree, const spAABB* aabb, spTreeQueryFunc func, spLazyPointer context);
+
+/// find new overlapping pairs for every proxy in the move buffer, then clear the buffer
+SPRING_API void spDynamicTreeUpdatePairs(spDynamicTree* tree, spTreePairFunc func, spLazyPointer context);
+
+/// check if the fat aabbs of two proxies overlap
+SPRING_API spBool spDynamicTreeTestOverlap(spDynamicTree* tree, spInt proxyA, spInt proxyB);
+
+/// get the fat aabb of a proxy
+SPRING_API spAABB spDynamicTreeGetFatAABB(spDynamicTree* tree, spInt proxyId);
+
+/// get the user data of a proxy
+SPRING_API spLazyPointer spDynamicTreeGetData(spDynamicTree* tree, spInt proxyId);
+
+/// set the margin added to proxies when they are inserted or reinserted. 0 if the aabbs given are already fat
+SPRING_API void spDynamicTreeSetMargin(spDynamicTree* tree, spFloat margin);
+
+/// get the height of the tree
+SPRING_API spInt spDynamicTreeGetHeight(spDynamicTree* tree);
+
+/// @}
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef SP_GRAPH_COLORING_H
+#define SP_GRAPH_COLORING_H
+
+#include "spIsland.h"
+
+/// number of colors constraints are split into, constraints that do not fit go to the overflow
+#define SP_GRAPH_COLORS 12
+
+/// index of the overflow bucket in the coloring
+#define SP_GRAPH_OVERFLOW SP_GRAPH_COLORS
+
+/// @defgroup spGraphColoring spGraphColoring
+/// @{
+
+/// the constraints of one color, no two of them share a dynamic body
+struct spGraphColor
+{
+    spInt contactStart; ///< first contact of the color in the colorings contact list
+    spInt contactCount; ///< number of contacts in the color
+    spInt jointStart;   ///< first joint of the color in the colorings joint list
+    spInt jointCount;   ///< number of joints in the color
+};
+
+/// splits the constraints of an island into colors. the constraints of a color can be solved at the
+/// same time on different threads, since none of them write to the same body. static and kinematic
+/// bodies are never written by the solver, so any number of constraints in a color can share them.
+/// constraints of bodies touching more than SP_GRAPH_COLORS others can run out of colors, those go
+/// to the overflow bucket, which is solved on one thread after the colors
+struct spGraphColoring
+{
+    spGraphColor colors[SP_GRAPH_COLORS + 1]; ///< the colors followed by the overflow bucket
+    spInt* contacts;       ///< indices of contacts in the worlds contact array, grouped by color
+    spConstraint** joints; ///< joints grouped by color
+    spUint* masks;         ///< scratch, bit c is set if a body node is already used by color c
+    spInt* colorOf;        ///< scratch, the color each joint then each contact was given
+    spInt contactCapacity; ///< size of the contact list
+    spInt jointCapacity;   ///< size of the joint list
+    spInt maskCapacity;    ///< size of the mask list
+    spInt colorCapacity;   ///< size of the color scratch
+};
+
+/// initialize an empty coloring
+SPRING_API void spGraphColoringInit(spGraphColoring* coloring);
+
+/// construct an empty coloring on the stack
+SPRING_API spGraphColoring spGraphColoringConstruct();
+
+/// release all memory held by the coloring
+SPRING_API void spGraphColoringDestroy(spGraphColoring* coloring);
+
+/// color the joints and contacts of an island found by an island graph. each constraint gets the first
+/// color none of its dynamic bodies use yet, and constraints keep their island order inside of a color.
+/// joints and contacts are colored apart, since the solver runs them in separate passes
+SPRING_API void spGraphColoringBuild(spGraphColoring* coloring, spIslandGraph* graph, spIsland* island, spContact* contacts);
+
+/// @}
+
+#endif
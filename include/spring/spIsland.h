@@ -0,0 +1,62 @@
+#ifndef SP_ISLAND_H
+#define SP_ISLAND_H
+
+#include "spCore.h"
+
+/// @defgroup spIsland spIsland
+/// @{
+
+/// a group of dynamic bodies that touch or are jointed to each other, directly or through other
+/// bodies in the group, along with the contacts and joints between them. islands do not affect
+/// each other, so each one can be solved, and put to sleep, on its own
+struct spIsland
+{
+    spInt bodyStart;    ///< first body of the island in the graphs body list
+    spInt bodyCount;    ///< number of bodies in the island
+    spInt contactStart; ///< first contact of the island in the graphs contact list
+    spInt contactCount; ///< number of contacts in the island
+    spInt jointStart;   ///< first joint of the island in the graphs joint list
+    spInt jointCount;   ///< number of joints in the island
+    spBool awake;       ///< spTrue if the island is simulated this step
+};
+
+/// the constraint graph of a world. dynamic bodies are the nodes, touching contacts and joints
+/// between two dynamic bodies are the edges. static and kinematic bodies do not join islands, so a
+/// pile resting on the ground is its own island. rebuilt every step with union find
+struct spIslandGraph
+{
+    spIsland* islands;     ///< islands, ordered by their first body in the body list
+    spBody** bodies;       ///< bodies grouped by island
+    spInt* contacts;       ///< indices of touching contacts in the worlds contact array, grouped by island
+    spConstraint** joints; ///< joints grouped by island
+    spBody** nodes;        ///< scratch, the dynamic bodies in body list order
+    spInt* parent;         ///< scratch, union find parent of each node
+    spInt* islandOf;       ///< scratch, island index of each node
+    spInt islandCount;     ///< number of islands
+    spInt bodyCount;       ///< number of bodies in all islands
+    spInt contactCount;    ///< number of contacts in all islands
+    spInt jointCount;      ///< number of joints in all islands
+    spInt bodyCapacity;    ///< size of the body, node and island lists
+    spInt contactCapacity; ///< size of the contact list
+    spInt jointCapacity;   ///< size of the joint list
+};
+
+/// initialize an empty island graph
+SPRING_API void spIslandGraphInit(spIslandGraph* graph);
+
+/// construct an empty island graph on the stack
+SPRING_API spIslandGraph spIslandGraphConstruct();
+
+/// release all memory held by the island graph
+SPRING_API void spIslandGraphDestroy(spIslandGraph* graph);
+
+/// find the islands of a world. bodies, contacts and joints keep their relative order inside of an
+/// island, so the result only depends on the order of the lists passed in. sets each bodys island node
+SPRING_API void spIslandGraphBuild(spIslandGraph* graph, spBody* bodyList, spConstraint* jointList, spContact* contacts, spInt contactCount);
+
+/// get the number of islands found by the last build
+SPRING_API spInt spIslandGraphGetIslandCount(spIslandGraph* graph);
+
+/// @}
+
+#endif
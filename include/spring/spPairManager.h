@@ -0,0 +1,53 @@
+#ifndef SP_PAIR_MANAGER_H
+#define SP_PAIR_MANAGER_H
+
+#include "spContact.h"
+
+/// @defgroup spPairManager spPairManager
+/// @{
+
+/// stores the worlds contacts in a dense array, and finds them by contact key with an
+/// open addressing hash table. lookup, insertion and removal are O(1) on average
+struct spPairManager
+{
+    spContact* contacts; ///< dense array of contacts
+    spInt* table;        ///< hash table of contact indices, -1 for empty slots
+    spInt count;         ///< number of contacts
+    spInt capacity;      ///< size of the contact array
+    spInt tableSize;     ///< size of the hash table, always a power of two
+};
+
+/// initialize an empty pair manager
+SPRING_API void spPairManagerInit(spPairManager* manager);
+
+/// construct an empty pair manager on the stack
+SPRING_API spPairManager spPairManagerConstruct();
+
+/// release all memory held by the pair manager
+SPRING_API void spPairManagerDestroy(spPairManager* manager);
+
+/// find the contact with a contact key, returns NULL if it does not exist
+SPRING_API spContact* spPairManagerFind(spPairManager* manager, spContactKey key);
+
+/// add a new contact with a contact key, returns NULL if the contact already exists.
+/// the returned pointer is only valid until the next add or remove
+SPRING_API spContact* spPairManagerAdd(spPairManager* manager, spContactKey key);
+
+/// remove the contact with a contact key if it exists
+SPRING_API void spPairManagerRemove(spPairManager* manager, spContactKey key);
+
+/// remove a contact by its index in the contact array. the last contact is moved into its place
+SPRING_API void spPairManagerRemoveAt(spPairManager* manager, spInt index);
+
+/// remove all contacts
+SPRING_API void spPairManagerClear(spPairManager* manager);
+
+/// get the dense array of contacts
+SPRING_API spContact* spPairManagerGetContacts(spPairManager* manager);
+
+/// get the number of contacts
+SPRING_API spInt spPairManagerGetCount(spPairManager* manager);
+
+/// @}
+
+#endif
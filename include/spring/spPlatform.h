@@ -10,4 +10,9 @@
   #define INLINE inline
 #endif
 
+/// sse2 is always available on x64, and on x86 when the compiler targets it. define SP_NO_SIMD to use scalar code
+#if !defined(SP_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+  #define SP_SSE2 1
+#endif
+
 #endif
@@ -22,6 +22,7 @@ struct spPolygon
     spShape shape;  ///< base shape class
     spFloat radius; ///< small radius added to polygon vertices
     spEdge* edges;  ///< array of edges. each edge contains a vertex and a normal
+    spEdge* worldEdges; ///< the edges in world space, updated whenever the bodys transform changes
     spInt count;    ///< number of edges
 };
 
@@ -43,6 +44,12 @@ SPRING_API void spPolygonFree(spShape** poly);
 /// tests if a point is inside of the polygon
 SPRING_API spBool spPolygonTestPoint(spPolygon* poly, spVector point);
 
+/// compute the polygons tight aabb from its world space vertices
+SPRING_API spAABB spPolygonComputeAABB(spPolygon* poly);
+
+/// transform the polygons edges into world space. called by the body whenever its transform changes
+SPRING_API void spPolygonUpdateWorldEdges(spPolygon* poly, const spTransform* xf);
+
 /// gets the polygons radius
 SPRING_API spFloat spPolygonGetRadius(spPolygon* poly);
 
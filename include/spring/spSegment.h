@@ -35,6 +35,9 @@ SPRING_API void spSegmentFree(spShape** segment);
 /// check if a point is inside of the segment
 SPRING_API spBool spSegmentTestPoint(spSegment* segment, const spVector point);
 
+/// compute the segments tight aabb in world space from its transformed end points
+SPRING_API spAABB spSegmentComputeAABB(spSegment* segment);
+
 /// get the first segment point in local space
 SPRING_API spVector spSegmentGetPointA(spSegment* segment);
 
@@ -52,6 +52,8 @@ struct spShape
     spShape* prev;        ///< previous shape in the doubly linked list
     spBound  bound;       ///< bounding volume of the shape
     spBody*  body;        ///< the body the shape is attached to
+    spAABB   aabb;        ///< fat aabb of the shapes broadphase proxy
+    spInt    proxyId;     ///< the shapes proxy in the worlds broadphase
 };
 
 /// create a physics material on the stack
@@ -72,6 +74,16 @@ SPRING_API spBool spShapeLessThan(const spShape* a, const spShape* b);
 /// tests a point to see if it is inside of a shape
 SPRING_API spBool spShapeTestPoint(spShape* shape, spVector point);
 
+/// compute the shapes tight aabb in world space
+SPRING_API spAABB spShapeComputeAABB(spShape* shape);
+
+/// get the radius of a circle around the bound center that contains the whole shape
+SPRING_API spFloat spShapeGetBoundRadius(const spShape* shape);
+
+/// get the distance from the bodys center of mass to the furthest point of the shape.
+/// rotating the body by an angle moves no point of the shape further than reach * angle
+SPRING_API spFloat spShapeGetReach(const spShape* shape);
+
 /// check if two shapes can collide via collision filtering
 SPRING_API spBool spShapesCanCollide(spShape* a, spShape* b);
 
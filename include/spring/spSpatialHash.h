@@ -0,0 +1,112 @@
+#ifndef SP_SPATIAL_HASH_H
+#define SP_SPATIAL_HASH_H
+
+#include "spBound.h"
+
+/// @defgroup spSpatialHash spSpatialHash
+/// @{
+
+/// index used for null entries and invalid proxies
+#define SP_NULL_PROXY (-1)
+
+/// default width of a grid cell
+#define SP_GRID_CELL_SIZE 32.0f
+
+/// margin added to each side of a proxy's aabb, as a fraction of the cell size
+#define SP_GRID_EXTENSION 0.125f
+
+/// a shape's proxy in the grid
+struct spGridProxy
+{
+    spAABB aabb;        ///< fat aabb of the proxy
+    spLazyPointer data; ///< user data of the proxy (the shape)
+    spInt minX, minY;   ///< lower cell of the range of cells the proxy is in
+    spInt maxX, maxY;   ///< upper cell of the range of cells the proxy is in
+    spInt next;         ///< next free proxy in the pool
+    spInt stamp;        ///< last query that visited this proxy
+    spBool moved;       ///< the proxy left its fat box since the last pair update
+};
+
+/// a proxy's entry in one cell of the grid
+struct spGridEntry
+{
+    spInt proxy; ///< the proxy in the cell
+    spInt x, y;  ///< the cell, many cells can hash to the same bucket
+    spInt next;  ///< next entry in the bucket, or the next free entry
+};
+
+/// uniform grid broadphase, stored sparsely in a hash table of cells. works best when
+/// shapes are about the same size as a cell. proxies are fattened like in the tree and
+/// are only rehashed when they leave their fat box and the range of cells they touch changes
+struct spSpatialHash
+{
+    spGridProxy* proxies;  ///< proxy pool
+    spGridEntry* entries;  ///< entry pool
+    spInt* buckets;        ///< first entry of each bucket
+    spInt* moveBuffer;     ///< proxies that were inserted or moved since the last pair update
+    spFloat cellSize;      ///< width of a cell
+    spFloat invCellSize;   ///< inverse width of a cell
+    spFloat margin;        ///< margin added to each side of a proxy's aabb
+    spInt proxyCount;      ///< number of proxies in use
+    spInt proxyCapacity;   ///< size of the proxy pool
+    spInt proxyFreeList;   ///< first free proxy
+    spInt entryCount;      ///< number of entries in use
+    spInt entryCapacity;   ///< size of the entry pool
+    spInt entryFreeList;   ///< first free entry
+    spInt bucketCount;     ///< number of buckets, always a power of two
+    spInt moveCount;       ///< number of proxies in the move buffer
+    spInt moveCapacity;    ///< size of the move buffer
+    spInt stamp;           ///< current query stamp
+};
+
+/// called for each proxy whose fat aabb overlaps the query box. return spFalse to stop the query
+typedef spBool (*spGridQueryFunc)(spLazyPointer context, spInt proxyId);
+
+/// called for each new pair of overlapping proxies found during a pair update
+typedef void (*spGridPairFunc)(spLazyPointer context, spLazyPointer dataA, spLazyPointer dataB);
+
+/// initialize an empty grid with a cell size
+SPRING_API void spSpatialHashInit(spSpatialHash* grid, spFloat cellSize);
+
+/// construct an empty grid on the stack
+SPRING_API spSpatialHash spSpatialHashConstruct(spFloat cellSize);
+
+/// release all memory held by the grid
+SPRING_API void spSpatialHashDestroy(spSpatialHash* grid);
+
+/// insert a proxy into the grid given a tight aabb, returns the proxy id
+SPRING_API spInt spSpatialHashInsertProxy(spSpatialHash* grid, const spAABB* aabb, spLazyPointer data);
+
+/// remove a proxy from the grid
+SPRING_API void spSpatialHashRemoveProxy(spSpatialHash* grid, spInt proxyId);
+
+/// move a proxy given its new tight aabb. returns spTrue if the proxy left its fat box
+SPRING_API spBool spSpatialHashMoveProxy(spSpatialHash* grid, spInt proxyId, const spAABB* aabb);
+
+/// query the grid for all proxies that overlap an aabb
+SPRING_API void spSpatialHashQuery(spSpatialHash* grid, const spAABB* aabb, spGridQueryFunc func, spLazyPointer context);
+
+/// find new overlapping pairs for every proxy in the move buffer, then clear the buffer
+SPRING_API void spSpatialHashUpdatePairs(spSpatialHash* grid, spGridPairFunc func, spLazyPointer context);
+
+/// check if the fat aabbs of two proxies overlap
+SPRING_API spBool spSpatialHashTestOverlap(spSpatialHash* grid, spInt proxyA, spInt proxyB);
+
+/// get the fat aabb of a proxy
+SPRING_API spAABB spSpatialHashGetFatAABB(spSpatialHash* grid, spInt proxyId);
+
+/// get the user data of a proxy
+SPRING_API spLazyPointer spSpatialHashGetData(spSpatialHash* grid, spInt proxyId);
+
+/// get the width of a cell
+SPRING_API spFloat spSpatialHashGetCellSize(spSpatialHash* grid);
+
+/// set the width of a cell, every proxy is rehashed
+SPRING_API void spSpatialHashSetCellSize(spSpatialHash* grid, spFloat cellSize);
+
+/// set the margin added to proxies when they are inserted or moved. 0 if the aabbs given are already fat
+SPRING_API void spSpatialHashSetMargin(spSpatialHash* grid, spFloat margin);
+
+/// @}
+
+#endif
@@ -1,66 +1,106 @@
-
-#ifndef SP_SORT_AND_SWEEP_H
-#define SP_SORT_AND_SWEEP_H
-
-#include "spBound.h"
-
-#define SP_MAX_SAP_OBJECTS 512
-
-/// interval along a 1D axis
-struct spInterval
-{
-    spFloat min, max; /// min and max values along an axis
-};
-
-/// sap box entry in the broadphase, min bound sorted along the x or y axis
-struct spSapBox
-{
-    spShape* shape;
-    spInterval axis[2];
-};
-
-/// sap broadphase
-struct spSap
-{
-    spSapBox* boxes[SP_MAX_SAP_OBJECTS]; /// array of boxes @TODO: change to dynamic array in the future
-    spInt count; /// count of objects in the array
-};
-
-typedef struct 
-{
-    spFloat axis[2];
-} spVariance;
-
-SPRING_API extern spAxis g_axis; /// axis to sort against (highest variance)
-
-/// construct a new sweep and prune broadphase
-SPRING_API spSap spSapConstruct();
-
-/// destroy a sweep and prune broadphase and release all resources
-SPRING_API void spSapDestroy(spSap* sap);
-
-/// insert a shape in the sweep and prune broadphase
-SPRING_API void spSapInsert(spSap* sap, spShape* shape);
-
-/// remove a shape in the sweep and prune broadphase
-SPRING_API void spSapRemove(spSap* sap, spShape* shape);
-
-/// update each box in the broadphase by updating the interval to world space
-SPRING_API void spSapUpdate(spSap* sap);
-
-/// sort each box in the broadphase using quicksort for now (radix sort can improve speed in some situations)
-SPRING_API void spSapSort(spSap* sap);
-
-/// compute the variance, and set new axis accordingly to help reduce o(n^2) during clustering
-SPRING_API spVariance spSapVariance(spSap* sap);
-
-/// update to have SAP sort on the axis with the highest variance
-SPRING_API void spSapUpdateSortAxis(spSap* sap);
-
-/// check if two intervals do not overlap
-SPRING_API spBool spIntervalsDontOverlap(spSapBox** boxes, spInt i, spInt j);
-
-/// check if two boxes overlap
-SPRING_API spBool spBoxesOverlap(spSapBox* a, spSapBox* b);
-
-#endif
\ No newline at end of file
+#ifndef SP_SORT_AND_SWEEP_H
+#define SP_SORT_AND_SWEEP_H
+
+#include "spBound.h"
+
+/// interval along a 1D axis
+struct spInterval
+{
+    spFloat min, max; /// min and max values along an axis
+};
+
+/// sap box entry in the broadphase, holds the world space intervals of a shape
+struct spSapBox
+{
+    spShape* shape;     ///< the shape this box bounds, NULL if the box is not in use
+    spInterval axis[2]; ///< world space intervals along the x and y axis
+    spInt next;         ///< next box in the free list
+    spBool stale;       ///< the box is pending or moved since the last update, so its endpoints do not match its intervals
+};
+
+/// min or max endpoint of a box along one axis
+struct spSapEndpoint
+{
+    spFloat value; ///< position of the endpoint along the axis
+    spInt   data;  ///< box index shifted left once, the low bit is set for max endpoints
+};
+
+/// variance of the box centers along the x and y axis
+typedef struct
+{
+    spFloat axis[2];
+} spVariance;
+
+/// incremental sweep and prune broadphase. the min/max endpoints of every box are kept sorted
+/// along both axes between steps. since objects move very little each step, re-sorting with an
+/// insertion sort is close to O(n), and pairs are added/removed as endpoints swap past each other
+struct spSap
+{
+    spSapBox* boxes;              ///< pool of boxes
+    spSapEndpoint* endpoints[2];  ///< sorted endpoints along the x and y axis
+    spInt* pending;               ///< boxes inserted since the last update, not yet in the endpoint lists
+    spInt* moved;                 ///< boxes moved since the last update, their endpoints are stale until the next update
+    spSapEndpoint* fresh;         ///< scratch, the sorted endpoints of the pending boxes while they are merged in
+    spBool* isNew;                ///< scratch, spTrue for boxes being merged in, sized like the box pool and kept cleared
+    spInt* slots;                 ///< scratch, the open list slot of each box and the open box indices while pending boxes are swept
+    spFloat* bounds;              ///< scratch, the other axis intervals of the open boxes while pending boxes are swept
+    spInt boxCapacity;            ///< size of the box pool
+    spInt freeList;               ///< first free box in the pool
+    spInt endpointCount;          ///< number of endpoints along each axis
+    spInt endpointCapacity;       ///< size of each endpoint array
+    spInt pendingCount;           ///< number of pending boxes
+    spInt pendingCapacity;        ///< size of the pending array
+    spInt movedCount;             ///< number of moved boxes
+    spInt movedCapacity;          ///< size of the moved array
+    spInt freshCapacity;          ///< size of the fresh endpoint scratch
+    spInt slotCapacity;           ///< size of the slot scratch
+    spInt boundCapacity;          ///< size of the bound scratch
+    spInt removedCount;           ///< boxes removed since the last update, their endpoints are removed lazily
+    spInt count;                  ///< count of boxes in the broadphase
+    spFloat extent[2];            ///< widest box along the x and y axis when the endpoints were last set, bounds how far back a query looks
+    spVariance variance;          ///< variance of the boxes the last time the sweep axis was picked
+    spAxis axis;                  ///< axis to sweep new boxes along (highest variance)
+};
+
+/// called when the boxes of two shapes start or stop overlapping
+typedef void (*spSapPairFunc)(spLazyPointer context, spShape* shapeA, spShape* shapeB);
+
+/// called for each box that overlaps the query box. return spFalse to stop the query
+typedef spBool (*spSapQueryFunc)(spLazyPointer context, spInt box);
+
+/// construct a new sweep and prune broadphase
+SPRING_API spSap spSapConstruct();
+
+/// destroy a sweep and prune broadphase and release all resources
+SPRING_API void spSapDestroy(spSap* sap);
+
+/// insert a shape in the sweep and prune broadphase given its world aabb, returns the box index
+SPRING_API spInt spSapInsert(spSap* sap, spShape* shape, const spAABB* aabb);
+
+/// remove a box from the sweep and prune broadphase
+SPRING_API void spSapRemove(spSap* sap, spInt box);
+
+/// move a box to a new world aabb, the endpoints are re-sorted during the next update
+SPRING_API void spSapMove(spSap* sap, spInt box, const spAABB* aabb);
+
+/// re-sort the endpoints, and report pairs that started or stopped overlapping
+SPRING_API void spSapUpdate(spSap* sap, spSapPairFunc addPair, spSapPairFunc removePair, spLazyPointer context);
+
+/// query the sweep and prune broadphase for all boxes that overlap an aabb. the endpoints of the sweep
+/// axis are binary searched, so only boxes near the query are tested, plus the boxes pending or moved
+/// since the last update. one very wide box makes every query start further back along the axis
+SPRING_API void spSapQuery(spSap* sap, const spAABB* aabb, spSapQueryFunc func, spLazyPointer context);
+
+/// compute the variance, and set new axis accordingly to help reduce o(n^2) during clustering
+SPRING_API spVariance spSapVariance(spSap* sap);
+
+/// update to have SAP sweep on the axis with the highest variance, the axis is stored per sap so worlds can step concurrently
+SPRING_API void spSapUpdateSortAxis(spSap* sap);
+
+/// check if the boxes of two box indices overlap
+SPRING_API spBool spSapTestOverlap(spSap* sap, spInt boxA, spInt boxB);
+
+/// check if two boxes overlap
+SPRING_API spBool spBoxesOverlap(spSapBox* a, spSapBox* b);
+
+#endif
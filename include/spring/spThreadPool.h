@@ -0,0 +1,95 @@
+#ifndef SP_THREAD_POOL_H
+#define SP_THREAD_POOL_H
+
+#include "spCore.h"
+
+#if defined(_WIN32)
+  #define WIN32_LEAN_AND_MEAN
+  #include <windows.h>
+  typedef HANDLE             spThread;
+  typedef CRITICAL_SECTION   spMutex;
+  typedef CONDITION_VARIABLE spCondition;
+#else
+  #include <pthread.h>
+  typedef pthread_t       spThread;
+  typedef pthread_mutex_t spMutex;
+  typedef pthread_cond_t  spCondition;
+#endif
+
+/// @defgroup spThreadPool spThreadPool
+/// @{
+
+/// a parallel for job, called with a range of items and the index of the thread running it.
+/// thread 0 is always the thread that called spThreadPoolParallelFor
+typedef void (*spParallelForFunc)(spLazyPointer context, spInt begin, spInt end, spInt thread);
+
+/// a task job, called once for each task with the index of the thread running it
+typedef void (*spTaskFunc)(spLazyPointer context, spInt task, spInt thread);
+
+/// the tasks one thread was dealt. the owner runs them from the front, biggest first, and
+/// threads that ran out of tasks steal from the back, where the smallest ones are
+struct spTaskDeque
+{
+    spMutex mutex; ///< guards both ends
+    spInt front;   ///< next task the owner runs, an index into the pools task list
+    spInt back;    ///< one past the last task, the next one stolen is back - 1
+    spInt cost;    ///< total cost of the tasks dealt to this deque
+};
+
+/// a worker thread of the pool
+struct spThreadPoolWorker
+{
+    spThreadPool* pool; ///< the pool the worker belongs to
+    spThread thread;    ///< the os thread
+    spInt index;        ///< thread index passed to jobs, workers start at 1
+};
+
+/// a fixed set of worker threads that split parallel for jobs with the calling thread.
+/// a job is split into one contiguous range per thread, so the range a thread runs
+/// only depends on the item count and thread count
+struct spThreadPool
+{
+    spThreadPoolWorker* workers; ///< worker threads, threadCount - 1 of them
+    spMutex mutex;               ///< guards the job and the counters below
+    spCondition wake;            ///< signaled when a job is posted or the pool shuts down
+    spCondition done;            ///< signaled when the last range of a job finishes
+    spParallelForFunc func;      ///< current job
+    spLazyPointer context;       ///< current job context
+    spTaskDeque* deques;         ///< one task deque per thread
+    spInt* tasks;                ///< tasks of the current task job grouped by deque, and (cost, task) scratch for sorting them
+    spInt taskCapacity;          ///< number of tasks the task list can hold
+    spTaskFunc taskFunc;         ///< current task job
+    spLazyPointer taskContext;   ///< current task job context
+    spInt count;                 ///< current job item count
+    spInt ranges;                ///< number of ranges the current job is split into
+    spInt pending;               ///< ranges of the current job still running on workers
+    spInt generation;            ///< incremented for every job so workers know when to run
+    spInt threadCount;           ///< number of threads including the calling thread
+    spBool quit;                 ///< tells the workers to exit
+};
+
+/// create a thread pool on the heap. threadCount includes the thread that runs the jobs
+SPRING_API spThreadPool* spThreadPoolNew(spInt threadCount);
+
+/// join the worker threads and release the pool from the heap
+SPRING_API void spThreadPoolFree(spThreadPool** pool);
+
+/// run func over count items and wait for it to finish. each thread gets at least grain items,
+/// so small jobs use fewer threads and a job smaller than grain runs on the calling thread only
+SPRING_API void spThreadPoolParallelFor(spThreadPool* pool, spInt count, spInt grain, spParallelForFunc func, spLazyPointer context);
+
+/// run func once for every task in [0, count) and wait for them to finish. the tasks are dealt to
+/// the threads so each gets about the same total cost, and threads that finish early steal tasks
+/// from the others. costs can be NULL if every task costs about the same. the thread a task runs
+/// on changes from run to run, so tasks must not depend on each other
+SPRING_API void spThreadPoolRunTasks(spThreadPool* pool, spInt count, const spInt* costs, spTaskFunc func, spLazyPointer context);
+
+/// get the number of threads including the calling thread
+SPRING_API spInt spThreadPoolGetThreadCount(spThreadPool* pool);
+
+/// get the number of logical processors on the machine
+SPRING_API spInt spGetProcessorCount();
+
+/// @}
+
+#endif
@@ -2,9 +2,43 @@
 #ifndef SP_WORLD_H
 #define SP_WORLD_H
 
-#include "spSweepAndPrune.h"
+#include "spBroadPhase.h"
+#include "spPairManager.h"
+#include "spCollision.h"
+#include "spThreadPool.h"
+#include "spIsland.h"
+#include "spGraphColoring.h"
+#include "spContactSolver.h"
 #include "spMath.h"
 
+/// minimum number of contacts each thread collides in the narrowphase
+#define SP_NARROWPHASE_GRAIN 256
+
+/// islands with at least this many constraints are graph colored, so a single big island can be solved on many threads
+#define SP_COLORING_MIN_CONSTRAINTS 128
+
+/// minimum number of bodies or constraints each thread solves at once in a graph colored island
+#define SP_SOLVER_GRAIN 64
+
+/// bullets stop this far from the shape they hit, it has to be smaller than the contact slop
+#define SP_TOI_TARGET 0.05f
+
+/// conservative advancement iterations used to find a bullets time of impact with a shape
+#define SP_TOI_ITERATIONS 20
+
+/// the most times a bullet is stopped and swept again for the rest of a step
+#define SP_TOI_SUBSTEPS 4
+
+/// how long every body of an island has to stay below the sleep tolerances before the island falls asleep
+#define SP_TIME_TO_SLEEP 0.5f
+
+/// bodies moving slower than this are still enough to fall asleep. resting bodies keep a little of
+/// the velocity gravity adds each step, so this has to be above gravity times the step size
+#define SP_SLEEP_LINEAR_TOLERANCE 2.0f
+
+/// bodies turning slower than this are still enough to fall asleep, 3 degrees per second
+#define SP_SLEEP_ANGULAR_TOLERANCE (3.0f * SP_DEG_TO_RAD)
+
 /// forward declarations to reduce includes
 struct spConstraint;
 struct spContact;
@@ -18,11 +52,35 @@ struct spBody;
 struct spWorld
 {
     spConstraint* jointList; ///< list of active constraints
-    spContact* contactList;  ///< list of active contacts
+    spPairManager pairs;     ///< active contacts, stored densely and hashed by contact key
     spBody* bodyList;        ///< list of active bodies
-    spSap sweepAndPrune;     ///< sweep and prune broadphase
+    spBroadPhase* broadPhase; ///< the broadphase used to find pairs between dynamic and kinematic shapes
+    spDynamicTree staticTree; ///< static shapes, only touched when static bodies are added, removed or moved
+    spCollisionResult* results; ///< narrowphase scratch, the collision result of each contact
+    spInt* circlePairs;      ///< narrowphase scratch, contacts between two circles that are collided as a batch
+    spInt resultCapacity;    ///< size of the narrowphase scratch buffers
+    spThreadPool* threadPool; ///< worker threads for the narrowphase and the island solver, NULL to run single threaded
+    spIslandGraph islands;   ///< islands found in the last step
+    spInt* islandTasks;      ///< solver scratch, the islands that are awake this step
+    spInt* islandCosts;      ///< solver scratch, the number of bodies and constraints in each awake island
+    spInt islandCapacity;    ///< size of the solver scratch buffers
+    spGraphColoring coloring; ///< colors of the big island being solved
+    spSolverBody* solverBodies; ///< solver scratch, the velocity and mass of each dynamic body indexed by island node
+    spContactConstraint* contactConstraints; ///< solver scratch, the touching contacts packed in island order
+    spInt solverBodyCapacity; ///< size of the solver body scratch
+    spInt constraintCapacity; ///< size of the contact constraint scratch
+    spWideContactConstraint* wideConstraints; ///< solver scratch, the contacts of each color of the big island packed four at a time
+    spInt wideCapacity;      ///< size of the wide constraint scratch
+    spBool simd;             ///< spTrue if big islands solve their contacts four at a time with sse2
+    spFloat gridCellSize;    ///< cell size used when the broadphase is a grid
+    spFloat aabbMargin;      ///< margin added to each side of a shapes tight aabb to make its fat proxy
     spVector gravity;        ///< world gravity
     spInt iterations;        ///< solver iterations
+    spInt gjkIterations;     ///< gjk iterations done by the last narrowphase, for profiling
+    spBool speculative;      ///< spTrue if contacts are made for pairs that can touch during the next step
+    spBool polygonSAT;       ///< spTrue if polygon pairs collide with sat, otherwise with gjk/epa
+    spFloat stepSize;        ///< length of the current step, used to predict how far shapes move
+    spBool sleeping;         ///< spTrue if islands that stay still are put to sleep
 };
 
 /// initialize a world
@@ -37,11 +95,8 @@ SPRING_API spWorld spWorldConstruct(spInt interations, spVector gravity);
 /// step through the simulation.
 SPRING_API void spWorldStep(spWorld* world, const spFloat dt);
 
-// do broad phase collision detection using sweep and prune
-SPRING_API void spWorldBroadPhaseSAP(spWorld* world);
-
-// do broad phase collision detection using brute force
-SPRING_API void spWorldBroadPhaseBruteForce(spWorld* world);
+/// move the proxies of shapes that left their fat aabb, and update the contacts of pairs that started or stopped overlapping
+SPRING_API void spWorldBroadPhase(spWorld* world);
 
 /// do narrow phase collision detection
 SPRING_API void spWorldNarrowPhase(spWorld* world);
@@ -49,12 +104,24 @@ SPRING_API void spWorldNarrowPhase(spWorld* world);
 /// test a point against all shapes in the world. the first one is returned
 SPRING_API spShape* spWorldTestPoint(spWorld* world, spVector point);
 
+/// query the broadphase for every shape whose bounds overlap an aabb
+SPRING_API void spWorldQuery(spWorld* world, const spAABB* aabb, spBroadPhaseQueryCallback func, spLazyPointer context);
+
 /// add a body to the world
 SPRING_API void spWorldAddBody(spWorld* world, spBody* body);
 
 /// remove a body from the world
 SPRING_API void spWorldRemoveBody(spWorld* world, spBody* body);
 
+/// add a shapes proxy to the broadphase, called when a shape is attached to a body in the world
+SPRING_API void spWorldAddShape(spWorld* world, spShape* shape);
+
+/// remove a shapes proxy from the broadphase and destroy its contacts
+SPRING_API void spWorldRemoveShape(spWorld* world, spShape* shape);
+
+/// update the static proxies of a static body that was moved by the user
+SPRING_API void spWorldMoveStaticBody(spWorld* world, spBody* body);
+
 /// add a constraint to the world
 SPRING_API void spWorldAddConstraint(spWorld* world, spConstraint* constraint);
 
@@ -64,8 +131,11 @@ SPRING_API void spWorldRemoveConstraint(spWorld* world, spConstraint** constrain
 /// get the worlds joint list
 SPRING_API spConstraint* spWorldGetJointList(spWorld* world);
 
-/// get the worlds contact list
-SPRING_API spContact* spWorldGetContactList(spWorld* world);
+/// get the worlds dense array of contacts
+SPRING_API spContact* spWorldGetContacts(spWorld* world);
+
+/// get the worlds number of contacts
+SPRING_API spInt spWorldGetContactCount(spWorld* world);
 
 /// get the worlds body list
 SPRING_API spBody* spWorldGetBodyList(spWorld* world);
@@ -76,12 +146,78 @@ SPRING_API spVector spWorldGetGravity(spWorld* world);
 /// get the worlds number of solver iterations
 SPRING_API spInt spWorldGetIterations(spWorld* world);
 
+/// get the worlds broadphase type
+SPRING_API spBroadPhaseType spWorldGetBroadPhase(spWorld* world);
+
+/// get the worlds broadphase
+SPRING_API spBroadPhase* spWorldGetBroadPhaseObject(spWorld* world);
+
+/// get the cell size of the worlds spatial hash grid
+SPRING_API spFloat spWorldGetGridCellSize(spWorld* world);
+
+/// get the margin added to each side of a shapes tight aabb
+SPRING_API spFloat spWorldGetAABBMargin(spWorld* world);
+
+/// get the total number of gjk iterations done by the last narrowphase
+SPRING_API spInt spWorldGetGJKIterations(spWorld* world);
+
+/// check if the world puts still islands to sleep
+SPRING_API spBool spWorldGetSleeping(spWorld* world);
+
+/// check if the world makes speculative contacts
+SPRING_API spBool spWorldGetSpeculativeContacts(spWorld* world);
+
+/// check if the world collides polygon pairs with sat
+SPRING_API spBool spWorldGetPolygonSAT(spWorld* world);
+
+/// check if the world solves contacts with simd
+SPRING_API spBool spWorldGetSIMD(spWorld* world);
+
+/// get the number of threads the world steps with
+SPRING_API spInt spWorldGetThreadCount(spWorld* world);
+
 /// set the worlds gravity
 SPRING_API void spWorldSetGravity(spWorld* world, spVector gravity);
 
 /// set the worlds solver iterations
 SPRING_API void spWorldSetIterations(spWorld* world, spInt iterations);
 
+/// set the worlds broadphase type, moves every shape into the new broadphase
+SPRING_API void spWorldSetBroadPhase(spWorld* world, spBroadPhaseType type);
+
+/// give the world a broadphase to use, such as a custom implementation. the world takes ownership
+/// of it, moves every shape into it, and frees the old broadphase
+SPRING_API void spWorldSetBroadPhaseObject(spWorld* world, spBroadPhase* broadPhase);
+
+/// set the cell size of the worlds spatial hash grid. about the size of the most common shape works best
+SPRING_API void spWorldSetGridCellSize(spWorld* world, spFloat cellSize);
+
+/// set the margin added to each side of a shapes tight aabb. a bigger margin touches the broadphase less
+/// often but creates more pairs for the narrowphase. proxies pick it up the next time they leave their fat box
+SPRING_API void spWorldSetAABBMargin(spWorld* world, spFloat margin);
+
+/// let islands fall asleep once all of their bodies have been still for a while. sleeping bodies are
+/// not integrated, collided or solved until they are touched, moved or pushed. on by default
+SPRING_API void spWorldSetSleeping(spWorld* world, spBool sleeping);
+
+/// make contacts for pairs that are still apart but close enough to touch during the next step, given their
+/// velocities. the solver lets them approach by the gap and no further, so fast bodies stop at the surface
+/// instead of sinking in and being pushed out. fat boxes are stretched along each bodies velocity to find these pairs
+SPRING_API void spWorldSetSpeculativeContacts(spWorld* world, spBool speculative);
+
+/// choose how the worlds polygons collide with each other. sat with reference/incident face clipping is the
+/// default, otherwise gjk/epa is used. rounded polygons always use gjk/epa. other worlds are not affected
+SPRING_API void spWorldSetPolygonSAT(spWorld* world, spBool sat);
+
+/// solve the contacts of graph colored islands four at a time with sse2. on by default when the cpu has it, and
+/// ignored when it does not. the wide solver does the same math in the same order, so the results do not change
+SPRING_API void spWorldSetSIMD(spWorld* world, spBool simd);
+
+/// set the number of threads the world steps with, 0 uses one per processor. the narrowphase is split
+/// across them, small islands are solved on them side by side, and big islands are graph colored so each
+/// color is split across them. the contacts and bodies after each step are the same for any thread count
+SPRING_API void spWorldSetThreadCount(spWorld* world, spInt threadCount);
+
 /// @}
 
 #endif
\ No newline at end of file
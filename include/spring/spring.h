@@ -8,24 +8,32 @@
 #include "spAngularSpringJoint.h"
 #include "spBody.h"
 #include "spBound.h"
+#include "spBroadPhase.h"
 #include "spCircle.h"
 #include "spCollision.h"
 #include "spConstraint.h"
 #include "spContact.h"
 #include "spContactKey.h"
+#include "spContactSolver.h"
 #include "spDistanceJoint.h"
+#include "spDynamicTree.h"
 #include "spGearJoint.h"
+#include "spGraphColoring.h"
+#include "spIsland.h"
 #include "spLinkedList.h"
 #include "spMotorJoint.h"
 #include "spMouseJoint.h"
+#include "spPairManager.h"
 #include "spPlatform.h"
 #include "spPointJoint.h"
 #include "spPolygon.h"
 #include "spRopeJoint.h"
 #include "spSegment.h"
 #include "spShape.h"
+#include "spSpatialHash.h"
 #include "spSpringJoint.h"
 #include "spSweepAndPrune.h"
+#include "spThreadPool.h"
 #include "spWheelJoint.h"
 #include "spWorld.h"
 
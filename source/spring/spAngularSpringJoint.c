@@ -55,13 +55,13 @@ WarmStart(spAngularSpringJoint* joint)
     /// apply last timesteps impulses
     if (joint->inverse)
     {
-        a->w += joint->lambdaAccum * a->iInv;
-        b->w -= joint->lambdaAccum * b->iInv;
+        spBodyApplyAngularImpulse(a,  joint->lambdaAccum);
+        spBodyApplyAngularImpulse(b, -joint->lambdaAccum);
     }
     else
     {
-        a->w +=  joint->lambdaAccum * a->iInv;
-        b->w -= -joint->lambdaAccum * b->iInv;
+        spBodyApplyAngularImpulse(a, joint->lambdaAccum);
+        spBodyApplyAngularImpulse(b, joint->lambdaAccum);
     }
 
     /// reset the lagrange multiplier
@@ -86,8 +86,8 @@ Solve(spAngularSpringJoint* joint)
         joint->lambdaAccum += lambda;
 
         /// apply the impulses
-        a->w += lambda * a->iInv;
-        b->w -= lambda * b->iInv;
+        spBodyApplyAngularImpulse(a,  lambda);
+        spBodyApplyAngularImpulse(b, -lambda);
     }
     else
     {
@@ -99,8 +99,8 @@ Solve(spAngularSpringJoint* joint)
         joint->lambdaAccum += lambda;
 
         /// apply the impulses
-        a->w +=  lambda * a->iInv;
-        b->w -= -lambda * b->iInv;
+        spBodyApplyAngularImpulse(a, lambda);
+        spBodyApplyAngularImpulse(b, lambda);
     }
 }
 
@@ -1,7 +1,7 @@
 
 #include "spConstraint.h"
 #include "spWorld.h"
-#include "spShape.h"
+#include "spPolygon.h"
 #include "spBody.h"
 
 #ifdef SP_DEBUG
@@ -21,14 +21,41 @@
     #define VALID(body) 
 #endif
 
+static void
+updateShapeTransform(spBody* body, spShape* shape)
+{
+    /// polygons cache their world space edges so collision does not transform them again
+    if (shape->type == SP_SHAPE_POLYGON)
+    {
+        spPolygonUpdateWorldEdges((spPolygon*)shape, &body->xf);
+    }
+}
+
 static void 
 updateTransform(spBody* body)
 {
     body->xf.q = spRotationConstruct(body->a);
     body->xf.p = spvAdd(sprTransform(body->xf.q, body->com), body->p);
+    for (spShape* shape = body->shapes; shape; shape = shape->next)
+    {
+        updateShapeTransform(body, shape);
+    }
     VALID(body);
 }
 
+static void
+bodyMoved(spBody* body)
+{
+    /// static bodies are not updated every step, tell the world the body was moved
+    if (body->world && body->type == SP_BODY_STATIC)
+    {
+        spWorldMoveStaticBody(body->world, body);
+    }
+
+    /// sleeping bodies are not updated either, wake it so its contacts are found again
+    spBodySetAwake(body, spTrue);
+}
+
 void 
 spBodyInit(spBody* body, spBodyType type)
 {
@@ -36,6 +63,7 @@ spBodyInit(spBody* body, spBodyType type)
     body->xf = spTransformConstruct(spVectorZero(), spRotationZero());
     body->com = spVectorZero();
     body->p = spVectorZero();
+    body->p0 = spVectorZero();
     body->f = spVectorZero();
     body->v = spVectorZero();
     body->gScale = 1.0f;
@@ -47,13 +75,19 @@ spBodyInit(spBody* body, spBodyType type)
     body->m = 0.0f;
     body->t = 0.0f;
     body->a = 0.0f;
+    body->a0 = 0.0f;
     body->w = 0.0f;
+    body->sleepTime = 0.0f;
     body->next = NULL;
     body->prev = NULL;
     body->i = 0.0f;
     body->m = 0.0f;
     body->world = NULL;
     body->shapes = NULL;
+    body->bullet = spFalse;
+    body->awake = spFalse;
+    body->islandNode = -1;
+    body->aabb = spAABBConstruct(spVectorZero(), spVectorZero());
     body->userData = NULL;
     spBodySetType(body, type);
     VALID(body);
@@ -160,11 +194,22 @@ spBodyAddShape(spBody* body, spShape* shape)
         spBodyComputeShapeMassData(body);
     }
     shape->body = body;
+    updateShapeTransform(body, shape);
+
+    /// the body is already simulating, add the shape to the broadphase
+    if (body->world)
+    {
+        spWorldAddShape(body->world, shape);
+    }
 }
 
 void 
 spBodyRemoveShape(spBody* body, spShape* shape)
 {
+    if (body->world)
+    {
+        spWorldRemoveShape(body->world, shape);
+    }
     SP_LINKED_LIST_REMOVE(spShape, shape, body->shapes);
     if (body->type == SP_BODY_DYNAMIC && body->shapes != NULL)
     {
@@ -213,6 +258,10 @@ spBodyIntegratePosition(spBody* body, const spFloat h)
     /// position += h * velocity
     /// rotation += h * angular_velocity
 
+    /// remember where the body started, so bullets can be swept
+    body->p0 = body->p;
+    body->a0 = body->a;
+
     /// integrate velocity to get new position/rotation
     body->p = spvAdd(body->p, spfvMult(h, body->v));
     body->a = body->a + body->w * h;
@@ -221,6 +270,13 @@ spBodyIntegratePosition(spBody* body, const spFloat h)
     updateTransform(body);
 }
 
+void
+spBodyUpdateTransform(spBody* body)
+{
+    NULLCHECK(body);
+    updateTransform(body);
+}
+
 spVector 
 spBodyAcceleration(spBody* body, const spVector gravity)
 {
@@ -303,6 +359,7 @@ spBodyWorldToLocalVector(spBody* body, spVector vector)
 void 
 spBodyApplyTorque(spBody* body, spFloat torque)
 {
+    spBodySetAwake(body, spTrue);
     body->t += torque;
 }
 
@@ -315,6 +372,7 @@ spBodyApplyForceAtLocalPoint(spBody* body, spVector point, spVector force)
 void 
 spBodyApplyForceAtWorldPoint(spBody* body, spVector point, spVector force)
 {
+    spBodySetAwake(body, spTrue);
     body->f  = spvAdd(body->f, force);
     body->t += spvCross(spvSub(point, spxTransform(body->xf, body->com)), force);
 }
@@ -328,10 +386,21 @@ spBodyApplyImpulseAtPoint(spBody* body, spVector point, spVector impulse)
 void 
 spBodyApplyImpulse(spBody* body, spVector relVelocity, spVector impulse)
 {
+    /// impulses cannot move static or kinematic bodies, and islands solved on different threads share them
+    if (body->type != SP_BODY_DYNAMIC) return;
+
     body->v  = spvAdd(body->v, spvfMult(impulse, body->mInv));
     body->w += body->iInv * spvCross(relVelocity, impulse);
 }
 
+void
+spBodyApplyAngularImpulse(spBody* body, spFloat impulse)
+{
+    if (body->type != SP_BODY_DYNAMIC) return;
+
+    body->w += body->iInv * impulse;
+}
+
 spTransform 
 spBodyGetTransform(spBody* body)
 {
@@ -422,6 +491,18 @@ spBodyGetType(spBody* body)
     return body->type;
 }
 
+spBool
+spBodyIsBullet(spBody* body)
+{
+    return body->bullet;
+}
+
+spBool
+spBodyIsAwake(spBody* body)
+{
+    return body->awake;
+}
+
 spShape* 
 spBodyGetShapeList(spBody* body)
 {
@@ -446,6 +527,7 @@ spBodySetTransform(spBody* body, const spVector position, spFloat angle)
     body->p = spvAdd(sprTransform(body->xf.q, body->com), position);
     body->a = angle * SP_DEG_TO_RAD;
     updateTransform(body);
+    bodyMoved(body);
 }
 
 void 
@@ -453,6 +535,7 @@ spBodySetPosition(spBody* body, const spVector position)
 {
     body->p = spvAdd(sprTransform(body->xf.q, body->com), position);
     updateTransform(body);
+    bodyMoved(body);
 }
 
 void 
@@ -460,6 +543,7 @@ spBodySetRotation(spBody* body, spRotation rotate)
 {
     body->a = spRotationGetAngle(rotate);
     updateTransform(body);
+    bodyMoved(body);
 }
 
 void 
@@ -467,6 +551,7 @@ spBodySetAngle(spBody* body, spFloat angle)
 {
     body->a = angle * SP_DEG_TO_RAD;
     updateTransform(body);
+    bodyMoved(body);
 }
 
 void 
@@ -478,6 +563,7 @@ spBodySetCenterOfMass(spBody* body, spVector com)
 void 
 spBodySetForce(spBody* body, spVector force)
 {
+    spBodySetAwake(body, spTrue);
     body->f = force;
 }
 
@@ -523,6 +609,17 @@ spBodySetMass(spBody* body, spFloat mass)
 void 
 spBodySetType(spBody* body, spBodyType type)
 {
+    /// static shapes are kept in their own broadphase, move the shapes if the body changes sides
+    spWorld* world = body->world;
+    spBool moveShapes = world && body->type != type && (body->type == SP_BODY_STATIC || type == SP_BODY_STATIC);
+    if (moveShapes)
+    {
+        for (spShape* shape = body->shapes; shape != NULL; shape = shape->next)
+        {
+            spWorldRemoveShape(world, shape);
+        }
+    }
+
     body->type = type;
 
     switch (type)
@@ -536,6 +633,40 @@ spBodySetType(spBody* body, spBodyType type)
         body->m = body->i = SP_INFINITY;
         body->v = spVectorZero();
     }
+
+    /// static bodies never move, so they are never awake
+    body->awake = type != SP_BODY_STATIC;
+    body->sleepTime = 0.0f;
+
+    if (moveShapes)
+    {
+        for (spShape* shape = body->shapes; shape != NULL; shape = shape->next)
+        {
+            spWorldAddShape(world, shape);
+        }
+    }
+}
+
+void
+spBodySetBullet(spBody* body, spBool bullet)
+{
+    body->bullet = bullet;
+}
+
+void
+spBodySetAwake(spBody* body, spBool awake)
+{
+    NULLCHECK(body);
+    if (body->type == SP_BODY_STATIC) return;
+
+    body->sleepTime = 0.0f;
+    body->awake = awake;
+    if (awake) return;
+
+    /// a sleeping body stays exactly where it is
+    body->v = spVectorZero();
+    body->w = 0.0f;
+    spBodyClearForces(body);
 }
 
 void 
@@ -99,4 +99,12 @@ spBoundSetRadius(spBound* bound, spFloat radius)
     NULLCHECK(bound);
     bound->radius = radius;
     bound->halfWidth = spVectorConstruct(radius, radius);
+}
+
+spAABB 
+spBoundGetWorldAABB(spBound* bound, spTransform* xf)
+{
+    NULLCHECK(bound); NULLCHECK(xf);
+    spVector center = spxTransform(*xf, bound->center);
+    return spAABBConstruct(spvSub(center, bound->halfWidth), spvAdd(center, bound->halfWidth));
 }
\ No newline at end of file
@@ -0,0 +1,513 @@
+#include "spBroadPhase.h"
+#include "spShape.h"
+#include "spBody.h"
+
+/// context used to forward proxy queries to a shape query callback
+typedef struct
+{
+    spBroadPhase* broadPhase;       ///< the broadphase being queried
+    spBroadPhaseQueryCallback func; ///< shape callback
+    spLazyPointer context;          ///< shape callback context
+} QueryContext;
+
+/// brute force
+
+static void
+BruteForceFree(spBruteForce** bruteForce)
+{
+    NULLCHECK(*bruteForce);
+    spFree(&(*bruteForce)->proxies);
+    if ((*bruteForce)->bodies)
+    {
+        spFree(&(*bruteForce)->bodies);
+    }
+    spFree(bruteForce);
+}
+
+static spInt
+BruteForceInsert(spBruteForce* bruteForce, spShape* shape, const spAABB* aabb)
+{
+    /// grow the proxy pool and link the new proxies into the free list
+    if (bruteForce->freeList == -1)
+    {
+        spInt capacity = bruteForce->capacity ? bruteForce->capacity * 2 : 64;
+        bruteForce->proxies = (spBruteForceProxy*) spRealloc(bruteForce->proxies, sizeof(spBruteForceProxy) * capacity);
+        NULLCHECK(bruteForce->proxies);
+        for (spInt i = bruteForce->capacity; i < capacity; ++i)
+        {
+            bruteForce->proxies[i].shape = NULL;
+            bruteForce->proxies[i].next = i + 1;
+        }
+        bruteForce->proxies[capacity-1].next = -1;
+        bruteForce->freeList = bruteForce->capacity;
+        bruteForce->capacity = capacity;
+    }
+
+    spInt proxyId = bruteForce->freeList;
+    spBruteForceProxy* proxy = bruteForce->proxies + proxyId;
+    bruteForce->freeList = proxy->next;
+    proxy->aabb = *aabb;
+    proxy->shape = shape;
+    proxy->next = -1;
+
+    return proxyId;
+}
+
+static void
+BruteForceRemove(spBruteForce* bruteForce, spInt proxyId)
+{
+    spAssert(0 <= proxyId && proxyId < bruteForce->capacity, "proxy id is out of range!");
+    bruteForce->proxies[proxyId].shape = NULL;
+    bruteForce->proxies[proxyId].next = bruteForce->freeList;
+    bruteForce->freeList = proxyId;
+}
+
+static void
+BruteForceMove(spBruteForce* bruteForce, spInt proxyId, const spAABB* aabb)
+{
+    spAssert(0 <= proxyId && proxyId < bruteForce->capacity, "proxy id is out of range!");
+    bruteForce->proxies[proxyId].aabb = *aabb;
+}
+
+static void
+BruteForceUpdatePairs(spBruteForce* bruteForce, spBroadPhasePairCallback addPair, spBroadPhasePairCallback removePair, spLazyPointer context)
+{
+    spBruteForceProxy* proxies = bruteForce->proxies;
+
+    /// gather each body once, through the proxy of the first shape in its shape list
+    spInt bodyCount = 0;
+    for (spInt i = 0; i < bruteForce->capacity; ++i)
+    {
+        spShape* shape = proxies[i].shape;
+        if (shape == NULL || shape != shape->body->shapes) continue;
+
+        if (bodyCount == bruteForce->bodyCapacity)
+        {
+            bruteForce->bodyCapacity = bruteForce->bodyCapacity ? bruteForce->bodyCapacity * 2 : 64;
+            bruteForce->bodies = (spBody**) spRealloc(bruteForce->bodies, sizeof(spBody*) * bruteForce->bodyCapacity);
+            NULLCHECK(bruteForce->bodies);
+        }
+        bruteForce->bodies[bodyCount++] = shape->body;
+    }
+
+    spBody** bodies = bruteForce->bodies;
+    for (spInt i = 0; i < bodyCount; ++i)
+    {
+        for (spInt j = i + 1; j < bodyCount; ++j)
+        {
+            /// cull the whole body pair before looking at their shapes
+            if (spAABBOverlap(&bodies[i]->aabb, &bodies[j]->aabb) == spFalse) continue;
+
+            for (spShape* shapeA = bodies[i]->shapes; shapeA; shapeA = shapeA->next)
+            {
+                for (spShape* shapeB = bodies[j]->shapes; shapeB; shapeB = shapeB->next)
+                {
+                    /// check if the shapes AABB's overlap
+                    if (spAABBOverlap(&proxies[shapeA->proxyId].aabb, &proxies[shapeB->proxyId].aabb) == spFalse) continue;
+
+                    addPair(context, shapeA, shapeB);
+                }
+            }
+        }
+    }
+}
+
+static void
+BruteForceQuery(spBruteForce* bruteForce, const spAABB* aabb, spBroadPhaseQueryCallback func, spLazyPointer context)
+{
+    for (spInt i = 0; i < bruteForce->capacity; ++i)
+    {
+        spBruteForceProxy* proxy = bruteForce->proxies + i;
+        if (proxy->shape == NULL) continue;
+
+        if (spAABBOverlap(&proxy->aabb, aabb) && func(context, proxy->shape) == spFalse)
+        {
+            return;
+        }
+    }
+}
+
+static spBool
+BruteForceTestOverlap(spBruteForce* bruteForce, spInt proxyA, spInt proxyB)
+{
+    return spAABBOverlap(&bruteForce->proxies[proxyA].aabb, &bruteForce->proxies[proxyB].aabb);
+}
+
+/// sweep and prune
+
+static void
+SapFree(spSapBroadPhase** sap)
+{
+    NULLCHECK(*sap);
+    spSapDestroy(&(*sap)->sap);
+    spFree(sap);
+}
+
+static spInt
+SapInsert(spSapBroadPhase* sap, spShape* shape, const spAABB* aabb)
+{
+    return spSapInsert(&sap->sap, shape, aabb);
+}
+
+static void
+SapRemove(spSapBroadPhase* sap, spInt proxyId)
+{
+    spSapRemove(&sap->sap, proxyId);
+}
+
+static void
+SapMove(spSapBroadPhase* sap, spInt proxyId, const spAABB* aabb)
+{
+    spSapMove(&sap->sap, proxyId, aabb);
+}
+
+static void
+SapUpdatePairs(spSapBroadPhase* sap, spBroadPhasePairCallback addPair, spBroadPhasePairCallback removePair, spLazyPointer context)
+{
+    spSapUpdate(&sap->sap, (spSapPairFunc)addPair, (spSapPairFunc)removePair, context);
+}
+
+static spBool
+SapQueryProxy(QueryContext* query, spInt proxyId)
+{
+    spSapBroadPhase* sap = (spSapBroadPhase*) query->broadPhase;
+    return query->func(query->context, sap->sap.boxes[proxyId].shape);
+}
+
+static void
+SapQuery(spSapBroadPhase* sap, const spAABB* aabb, spBroadPhaseQueryCallback func, spLazyPointer context)
+{
+    QueryContext query = { &sap->broadPhase, func, context };
+    spSapQuery(&sap->sap, aabb, (spSapQueryFunc)SapQueryProxy, &query);
+}
+
+static spBool
+SapTestOverlap(spSapBroadPhase* sap, spInt proxyA, spInt proxyB)
+{
+    return spSapTestOverlap(&sap->sap, proxyA, proxyB);
+}
+
+/// dynamic aabb tree
+
+static void
+TreeFree(spTreeBroadPhase** tree)
+{
+    NULLCHECK(*tree);
+    spDynamicTreeDestroy(&(*tree)->tree);
+    spFree(tree);
+}
+
+static spInt
+TreeInsert(spTreeBroadPhase* tree, spShape* shape, const spAABB* aabb)
+{
+    return spDynamicTreeInsertProxy(&tree->tree, aabb, shape);
+}
+
+static void
+TreeRemove(spTreeBroadPhase* tree, spInt proxyId)
+{
+    spDynamicTreeRemoveProxy(&tree->tree, proxyId);
+}
+
+static void
+TreeMove(spTreeBroadPhase* tree, spInt proxyId, const spAABB* aabb)
+{
+    spDynamicTreeMoveProxy(&tree->tree, proxyId, aabb);
+}
+
+static void
+TreeUpdatePairs(spTreeBroadPhase* tree, spBroadPhasePairCallback addPair, spBroadPhasePairCallback removePair, spLazyPointer context)
+{
+    /// pairs are removed by the world once their fat boxes stop overlapping
+    spDynamicTreeUpdatePairs(&tree->tree, (spTreePairFunc)addPair, context);
+}
+
+static spBool
+TreeQueryProxy(QueryContext* query, spInt proxyId)
+{
+    spTreeBroadPhase* tree = (spTreeBroadPhase*) query->broadPhase;
+    return query->func(query->context, (spShape*) spDynamicTreeGetData(&tree->tree, proxyId));
+}
+
+static void
+TreeQuery(spTreeBroadPhase* tree, const spAABB* aabb, spBroadPhaseQueryCallback func, spLazyPointer context)
+{
+    QueryContext query = { &tree->broadPhase, func, context };
+    spDynamicTreeQuery(&tree->tree, aabb, (spTreeQueryFunc)TreeQueryProxy, &query);
+}
+
+static spBool
+TreeTestOverlap(spTreeBroadPhase* tree, spInt proxyA, spInt proxyB)
+{
+    return spDynamicTreeTestOverlap(&tree->tree, proxyA, proxyB);
+}
+
+/// spatial hash grid
+
+static void
+GridFree(spGridBroadPhase** grid)
+{
+    NULLCHECK(*grid);
+    spSpatialHashDestroy(&(*grid)->grid);
+    spFree(grid);
+}
+
+static spInt
+GridInsert(spGridBroadPhase* grid, spShape* shape, const spAABB* aabb)
+{
+    return spSpatialHashInsertProxy(&grid->grid, aabb, shape);
+}
+
+static void
+GridRemove(spGridBroadPhase* grid, spInt proxyId)
+{
+    spSpatialHashRemoveProxy(&grid->grid, proxyId);
+}
+
+static void
+GridMove(spGridBroadPhase* grid, spInt proxyId, const spAABB* aabb)
+{
+    spSpatialHashMoveProxy(&grid->grid, proxyId, aabb);
+}
+
+static void
+GridUpdatePairs(spGridBroadPhase* grid, spBroadPhasePairCallback addPair, spBroadPhasePairCallback removePair, spLazyPointer context)
+{
+    /// pairs are removed by the world once their fat boxes stop overlapping
+    spSpatialHashUpdatePairs(&grid->grid, (spGridPairFunc)addPair, context);
+}
+
+static spBool
+GridQueryProxy(QueryContext* query, spInt proxyId)
+{
+    spGridBroadPhase* grid = (spGridBroadPhase*) query->broadPhase;
+    return query->func(query->context, (spShape*) spSpatialHashGetData(&grid->grid, proxyId));
+}
+
+static void
+GridQuery(spGridBroadPhase* grid, const spAABB* aabb, spBroadPhaseQueryCallback func, spLazyPointer context)
+{
+    QueryContext query = { &grid->broadPhase, func, context };
+    spSpatialHashQuery(&grid->grid, aabb, (spGridQueryFunc)GridQueryProxy, &query);
+}
+
+static spBool
+GridTestOverlap(spGridBroadPhase* grid, spInt proxyA, spInt proxyB)
+{
+    return spSpatialHashTestOverlap(&grid->grid, proxyA, proxyB);
+}
+
+/// broadphase functions
+
+void
+spBroadPhaseInitFuncs(spBroadPhaseFuncs* funcs, spBroadPhaseFreeFunc free, spBroadPhaseInsertFunc insert, spBroadPhaseRemoveFunc remove,
+                      spBroadPhaseMoveFunc move, spBroadPhaseUpdatePairsFunc updatePairs, spBroadPhaseQueryFunc query, spBroadPhaseTestOverlapFunc testOverlap)
+{
+    funcs->free = free;
+    funcs->insert = insert;
+    funcs->remove = remove;
+    funcs->move = move;
+    funcs->updatePairs = updatePairs;
+    funcs->query = query;
+    funcs->testOverlap = testOverlap;
+}
+
+void
+spBroadPhaseInit(spBroadPhase* broadPhase, spBroadPhaseType type)
+{
+    NULLCHECK(broadPhase);
+    broadPhase->type = type;
+}
+
+spBroadPhase*
+spBroadPhaseNew(spBroadPhaseType type)
+{
+    switch (type)
+    {
+    case SP_BROADPHASE_BRUTE_FORCE:
+        return spBruteForceNew();
+    case SP_BROADPHASE_SAP:
+        return spSapBroadPhaseNew();
+    case SP_BROADPHASE_TREE:
+        return spTreeBroadPhaseNew();
+    case SP_BROADPHASE_GRID:
+        return spGridBroadPhaseNew(SP_GRID_CELL_SIZE);
+    case SP_BROADPHASE_CUSTOM:
+        break;
+    }
+    spAssert(spFalse, "custom broadphases must be created by the user!");
+    return NULL;
+}
+
+spBroadPhase*
+spBruteForceNew()
+{
+    spBruteForce* bruteForce = (spBruteForce*) spMalloc(sizeof(spBruteForce));
+    NULLCHECK(bruteForce);
+    spBroadPhaseInit(&bruteForce->broadPhase, SP_BROADPHASE_BRUTE_FORCE);
+    spBroadPhaseInitFuncs(&bruteForce->broadPhase.funcs,
+        (spBroadPhaseFreeFunc)BruteForceFree,
+        (spBroadPhaseInsertFunc)BruteForceInsert,
+        (spBroadPhaseRemoveFunc)BruteForceRemove,
+        (spBroadPhaseMoveFunc)BruteForceMove,
+        (spBroadPhaseUpdatePairsFunc)BruteForceUpdatePairs,
+        (spBroadPhaseQueryFunc)BruteForceQuery,
+        (spBroadPhaseTestOverlapFunc)BruteForceTestOverlap);
+    bruteForce->proxies = NULL;
+    bruteForce->bodies = NULL;
+    bruteForce->capacity = 0;
+    bruteForce->bodyCapacity = 0;
+    bruteForce->freeList = -1;
+    return &bruteForce->broadPhase;
+}
+
+spBroadPhase*
+spSapBroadPhaseNew()
+{
+    spSapBroadPhase* sap = (spSapBroadPhase*) spMalloc(sizeof(spSapBroadPhase));
+    NULLCHECK(sap);
+    spBroadPhaseInit(&sap->broadPhase, SP_BROADPHASE_SAP);
+    spBroadPhaseInitFuncs(&sap->broadPhase.funcs,
+        (spBroadPhaseFreeFunc)SapFree,
+        (spBroadPhaseInsertFunc)SapInsert,
+        (spBroadPhaseRemoveFunc)SapRemove,
+        (spBroadPhaseMoveFunc)SapMove,
+        (spBroadPhaseUpdatePairsFunc)SapUpdatePairs,
+        (spBroadPhaseQueryFunc)SapQuery,
+        (spBroadPhaseTestOverlapFunc)SapTestOverlap);
+    sap->sap = spSapConstruct();
+    return &sap->broadPhase;
+}
+
+spBroadPhase*
+spTreeBroadPhaseNew()
+{
+    spTreeBroadPhase* tree = (spTreeBroadPhase*) spMalloc(sizeof(spTreeBroadPhase));
+    NULLCHECK(tree);
+    spBroadPhaseInit(&tree->broadPhase, SP_BROADPHASE_TREE);
+    spBroadPhaseInitFuncs(&tree->broadPhase.funcs,
+        (spBroadPhaseFreeFunc)TreeFree,
+        (spBroadPhaseInsertFunc)TreeInsert,
+        (spBroadPhaseRemoveFunc)TreeRemove,
+        (spBroadPhaseMoveFunc)TreeMove,
+        (spBroadPhaseUpdatePairsFunc)TreeUpdatePairs,
+        (spBroadPhaseQueryFunc)TreeQuery,
+        (spBroadPhaseTestOverlapFunc)TreeTestOverlap);
+    spDynamicTreeInit(&tree->tree);
+
+    /// the world hands the broadphase boxes that are already fat
+    spDynamicTreeSetMargin(&tree->tree, 0.0f);
+    return &tree->broadPhase;
+}
+
+spBroadPhase*
+spGridBroadPhaseNew(spFloat cellSize)
+{
+    spGridBroadPhase* grid = (spGridBroadPhase*) spMalloc(sizeof(spGridBroadPhase));
+    NULLCHECK(grid);
+    spBroadPhaseInit(&grid->broadPhase, SP_BROADPHASE_GRID);
+    spBroadPhaseInitFuncs(&grid->broadPhase.funcs,
+        (spBroadPhaseFreeFunc)GridFree,
+        (spBroadPhaseInsertFunc)GridInsert,
+        (spBroadPhaseRemoveFunc)GridRemove,
+        (spBroadPhaseMoveFunc)GridMove,
+        (spBroadPhaseUpdatePairsFunc)GridUpdatePairs,
+        (spBroadPhaseQueryFunc)GridQuery,
+        (spBroadPhaseTestOverlapFunc)GridTestOverlap);
+    spSpatialHashInit(&grid->grid, cellSize);
+
+    /// the world hands the broadphase boxes that are already fat
+    spSpatialHashSetMargin(&grid->grid, 0.0f);
+    return &grid->broadPhase;
+}
+
+void
+spBroadPhaseFree(spBroadPhase** broadPhase)
+{
+    NULLCHECK(*broadPhase);
+    (*broadPhase)->funcs.free(broadPhase);
+}
+
+spInt
+spBroadPhaseInsert(spBroadPhase* broadPhase, spShape* shape, const spAABB* aabb)
+{
+    return broadPhase->funcs.insert(broadPhase, shape, aabb);
+}
+
+void
+spBroadPhaseRemove(spBroadPhase* broadPhase, spInt proxyId)
+{
+    broadPhase->funcs.remove(broadPhase, proxyId);
+}
+
+void
+spBroadPhaseMove(spBroadPhase* broadPhase, spInt proxyId, const spAABB* aabb)
+{
+    broadPhase->funcs.move(broadPhase, proxyId, aabb);
+}
+
+void
+spBroadPhaseUpdatePairs(spBroadPhase* broadPhase, spBroadPhasePairCallback addPair, spBroadPhasePairCallback removePair, spLazyPointer context)
+{
+    broadPhase->funcs.updatePairs(broadPhase, addPair, removePair, context);
+}
+
+void
+spBroadPhaseQuery(spBroadPhase* broadPhase, const spAABB* aabb, spBroadPhaseQueryCallback func, spLazyPointer context)
+{
+    broadPhase->funcs.query(broadPhase, aabb, func, context);
+}
+
+spBool
+spBroadPhaseTestOverlap(spBroadPhase* broadPhase, spInt proxyA, spInt proxyB)
+{
+    return broadPhase->funcs.testOverlap(broadPhase, proxyA, proxyB);
+}
+
+spBroadPhaseType
+spBroadPhaseGetType(spBroadPhase* broadPhase)
+{
+    return broadPhase->type;
+}
+
+spSapBroadPhase*
+spBroadPhaseCastSap(spBroadPhase* broadPhase)
+{
+    if (broadPhase->type == SP_BROADPHASE_SAP)
+    {
+        return (spSapBroadPhase*) broadPhase;
+    }
+    else
+    {
+        spWarning(spFalse, "broadphase is not a sweep and prune\n");
+        return NULL;
+    }
+}
+
+spTreeBroadPhase*
+spBroadPhaseCastTree(spBroadPhase* broadPhase)
+{
+    if (broadPhase->type == SP_BROADPHASE_TREE)
+    {
+        return (spTreeBroadPhase*) broadPhase;
+    }
+    else
+    {
+        spWarning(spFalse, "broadphase is not a dynamic tree\n");
+        return NULL;
+    }
+}
+
+spGridBroadPhase*
+spBroadPhaseCastGrid(spBroadPhase* broadPhase)
+{
+    if (broadPhase->type == SP_BROADPHASE_GRID)
+    {
+        return (spGridBroadPhase*) broadPhase;
+    }
+    else
+    {
+        spWarning(spFalse, "broadphase is not a spatial hash grid\n");
+        return NULL;
+    }
+}
@@ -79,6 +79,15 @@ spCircleTestPoint(spCircle* circle, spVector point)
     return spvLength(spvSub(point, center)) <= circle->radius;
 }
 
+spAABB 
+spCircleComputeAABB(spCircle* circle)
+{
+    NULLCHECK(circle);
+    spVector center = spxTransform(circle->shape.body->xf, circle->center);
+    spVector radius = spVectorConstruct(circle->radius, circle->radius);
+    return spAABBConstruct(spvSub(center, radius), spvAdd(center, radius));
+}
+
 spVector 
 spCircleGetLocalCenter(spCircle* circle)
 {
@@ -3,8 +3,13 @@
 #include "spSegment.h"
 #include "spPolygon.h"
 #include "spCircle.h"
+#include "spContact.h"
 #include "spBody.h"
 
+#ifdef SP_SSE2
+#include <emmintrin.h>
+#endif
+
 /// typedef structs for convenience
 typedef struct SupportPointContext SupportPointContext;
 typedef struct spMinkowskiPoint spMinkowskiPoint;
@@ -15,7 +20,8 @@ typedef struct Edge Edge;
 /// an edge of two points
 struct Edge
 {
-    spVector a, b; ///< edge points
+    spVector a, b;          ///< edge points
+    spInt vertexA, vertexB; ///< shape vertex indices of the edge points
 };
 
 /// a point on the minkowski difference of two shapes
@@ -49,6 +55,7 @@ struct SupportPointContext
     spShape* shapeB;                ///< the second shape
     SupportPointFunc supportPointA; ///< the first  shapes support point function
     SupportPointFunc supportPointB; ///< the second shapes support point function
+    spCollisionCache* cache;        ///< the pairs cache, holds the support hints of each shape
 };
 
 static INLINE spFloat
@@ -151,6 +158,8 @@ spCollisionResultConstruct()
     result.pointB[0] = spVectorZero();
     result.pointA[1] = spVectorZero();
     result.pointB[1] = spVectorZero();
+    result.id[0]     = 0;
+    result.id[1]     = 0;
     result.normal    = spVectorZero();
     result.count     = 0;
 
@@ -170,7 +179,7 @@ spMinkowskiPointConstruct(spVector a, spVector b)
 }
 
 static void
-addContact(spCollisionResult* result, const spVector pointA, const spVector pointB)
+addContact(spCollisionResult* result, const spVector pointA, const spVector pointB, const spUint id)
 {
     NULLCHECK(result);
     spAssert(result->count <= 2, "cannot add more than 2 contacts!");
@@ -179,6 +188,7 @@ addContact(spCollisionResult* result, const spVector pointA, const spVector poin
     result->colliding = spTrue;
 	result->pointA[result->count] = pointA;
 	result->pointB[result->count] = pointB;
+    result->id[result->count] = id;
 	result->count++;
 }
 
@@ -192,12 +202,15 @@ invertContacts(spCollisionResult* result)
         spVector tmp = result->pointA[i];
 		result->pointA[i] = result->pointB[i];
 		result->pointB[i] = tmp;
+
+        /// swap the features of shape a and b
+        result->id[i] = (result->id[i] >> 16) | (result->id[i] << 16);
     }
     result->normal = spNegative(result->normal);
 }
 
 static spVector
-extremalPointCircle(const spCircle* circle, const spVector normal)
+extremalPointCircle(const spCircle* circle, const spVector normal, spInt* hint)
 {
     NULLCHECK(circle);
     /// circles are tested as points with a radius, return the world center
@@ -205,7 +218,7 @@ extremalPointCircle(const spCircle* circle, const spVector normal)
 }
 
 static spVector
-extremalPointSegment(const spSegment* segment, const spVector normal)
+extremalPointSegment(const spSegment* segment, const spVector normal, spInt* hint)
 {
     NULLCHECK(segment);
     spTransform* xf = &segment->shape.body->xf;
@@ -229,111 +242,122 @@ extremalEdgeSegment(const spSegment* segment, const spVector normal)
 
     if (spDot(segment->normal, normal) > 0.0f)
     {
-        edge.a = pointB;
-        edge.b = pointA;
+        edge.a = pointB; edge.vertexA = 1;
+        edge.b = pointA; edge.vertexB = 0;
     }
     else
     {
-        edge.a = pointA;
-        edge.b = pointB;
+        edge.a = pointA; edge.vertexA = 0;
+        edge.b = pointB; edge.vertexB = 1;
     }
 
     return edge;
 }
 
 static spInt
-extremalIndexPoly(const spPolygon* poly, const spVector normal)
+hillClimbPoly(const spPolygon* poly, const spVector normal, spInt start)
 {
     NULLCHECK(poly);
-    spTransform* xf = &poly->shape.body->xf;
-
-    /// poly edges and count
-    spEdge* edges = poly->edges;
+    spEdge* edges = poly->worldEdges;
     spInt count   = poly->count;
 
-    spFloat maxProj = -SP_MAX_FLT;
-    spInt index = 0;
+    spInt index = start;
+    spFloat maxProj = spDot(edges[index].vertex, normal);
 
-    /// find the most extreme point along a direction
-    for (spInt i = 0; i < count; ++i)
+    /// the polygon is convex, so walk towards the neighbor that is further along the direction until neither is
+    for (;;)
     {
-        spEdge*    e = edges + i;
-        spVector   v = spxTransform(*xf, e->vertex);
-        spFloat proj = spDot(v, normal);
+        spInt next = index == count-1 ? 0 : index+1;
+        spInt prev = index == 0 ? count-1 : index-1;
+        spFloat nextProj = spDot(edges[next].vertex, normal);
+        spFloat prevProj = spDot(edges[prev].vertex, normal);
 
-        /// this projection is larger, save its info
-        if (proj > maxProj)
+        if (nextProj > maxProj && nextProj >= prevProj)
         {
-            maxProj = proj;
-            index = i;
+            index = next;
+            maxProj = nextProj;
+        }
+        else if (prevProj > maxProj)
+        {
+            index = prev;
+            maxProj = prevProj;
+        }
+        else
+        {
+            return index;
         }
     }
-
-    /// return the extremal vertex of the poly along a direction
-    return index;
 }
 
-static spVector
-extremalPointPoly(const spPolygon* poly, const spVector normal)
+static spInt
+extremalIndexPoly(const spPolygon* poly, const spVector normal, spInt* hint)
 {
     NULLCHECK(poly);
-    spTransform* xf = &poly->shape.body->xf;
-
-    /// poly edges and count
-    spEdge* edges = poly->edges;
+    /// poly world edges and count
+    spEdge* edges = poly->worldEdges;
     spInt count   = poly->count;
 
+    /// large polygons start from the last support vertex, which is usually at or next to the new one
+    if (hint && count >= SP_HILL_CLIMB_VERTICES)
+    {
+        spInt start = 0 <= *hint && *hint < count ? *hint : 0;
+        return *hint = hillClimbPoly(poly, normal, start);
+    }
+
     spFloat maxProj = -SP_MAX_FLT;
-    spVector maxVec = spVectorZero();
+    spInt index = 0;
 
     /// find the most extreme point along a direction
     for (spInt i = 0; i < count; ++i)
     {
-        spEdge*    e = edges + i;
-        spVector   v = spxTransform(*xf, e->vertex);
-        spFloat proj = spDot(v, normal);
+        spFloat proj = spDot(edges[i].vertex, normal);
 
         /// this projection is larger, save its info
         if (proj > maxProj)
         {
             maxProj = proj;
-            maxVec = v;
+            index = i;
         }
     }
 
     /// return the extremal vertex of the poly along a direction
-    return maxVec;
+    return index;
 }
 
-static Edge
-extremalEdgePoly(const spPolygon* poly, const spVector normal)
+static spVector
+extremalPointPoly(const spPolygon* poly, const spVector normal, spInt* hint)
 {
     NULLCHECK(poly);
-    spTransform* xf = &poly->shape.body->xf;
+    return poly->worldEdges[extremalIndexPoly(poly, normal, hint)].vertex;
+}
 
-    /// poly edges and count
-    spEdge* edges = poly->edges;
+static Edge
+extremalEdgePoly(const spPolygon* poly, const spVector normal, spInt* hint)
+{
+    NULLCHECK(poly);
+    /// poly world edges and count
+    spEdge* edges = poly->worldEdges;
     spInt   count = poly->count;
 
     /// get the edge vertex indices
-    spInt index1 = extremalIndexPoly(poly, normal);
+    spInt index1 = extremalIndexPoly(poly, normal, hint);
     spInt index2 = index1 == 0 ? count-1 : index1-1;
     spInt index0 = index1 == count-1 ? 0 : index1+1;
 
-    /// get the normals rotated in world space
-    spVector normal1 = spNormal(sprTransform(xf->q, edges[index1].normal));
-    spVector normal2 = spNormal(sprTransform(xf->q, edges[index2].normal));
+    /// get the world space normals
+    spVector normal1 = edges[index1].normal;
+    spVector normal2 = edges[index2].normal;
 
     Edge edge;
     if (spDot(normal, normal1) > spDot(normal, normal2))
     {
-        edge.a = spxTransform(*xf, edges[index1].vertex);
-        edge.b = spxTransform(*xf, edges[index0].vertex);
+        edge.a = edges[index1].vertex; edge.vertexA = index1;
+        edge.b = edges[index0].vertex; edge.vertexB = index0;
     }
     else
     {
-        edge.a = spxTransform(*xf, edges[index2].vertex);
-        edge.b = spxTransform(*xf, edges[index1].vertex);
+        edge.a = edges[index2].vertex; edge.vertexA = index2;
+        edge.b = edges[index1].vertex; edge.vertexB = index1;
     }
 
     return edge;
@@ -343,8 +367,8 @@ static struct spMinkowskiPoint
 supportPoint(const struct SupportPointContext* context, const spVector normal)
 {
     NULLCHECK(context);
-    spVector pointA = context->supportPointA(context->shapeA, normal);
-    spVector pointB = context->supportPointB(context->shapeB, spNegative(normal));
+    spVector pointA = context->supportPointA(context->shapeA, normal, context->cache->support + 0);
+    spVector pointB = context->supportPointB(context->shapeB, spNegative(normal), context->cache->support + 1);
 
     return spMinkowskiPointConstruct(pointA, pointB);
 }
@@ -381,7 +405,7 @@ edgesOverlap(const struct Edge* a, const struct Edge* b, spVector normal)
 }
 
 static spCollisionResult
-clipEdges(const struct Edge* a, const struct Edge* b, const struct MinkowskiEdge* edge, spFloat radiusA, spFloat radiusB)
+clipEdges(const struct Edge* a, const struct Edge* b, const struct MinkowskiEdge* edge, spFloat radiusA, spFloat radiusB, spFloat margin)
 {
     NULLCHECK(a); NULLCHECK(b); NULLCHECK(edge);
     spCollisionResult result = spCollisionResultConstruct();
@@ -410,9 +434,9 @@ clipEdges(const struct Edge* a, const struct Edge* b, const struct MinkowskiEdge
 
         /// compute the penetration to see if they are in contact
         spFloat penetration = -spDot(spvSub(pointB, pointA), normal);
-        if (penetration > 0.0f)
+        if (penetration > -margin)
         {
-            addContact(&result, pointA, pointB);
+            addContact(&result, pointA, pointB, SP_FEATURE_ID(SP_FEATURE_VERTEX(a->vertexA), SP_FEATURE_VERTEX(b->vertexB)));
         }
     } {
         /// get lerp ratios of the clipped points
@@ -425,9 +449,9 @@ clipEdges(const struct Edge* a, const struct Edge* b, const struct MinkowskiEdge
 
         /// compute the penetration to see if they are in contact
         spFloat penetration = -spDot(spvSub(pointB, pointA), normal);
-        if (penetration >= 0.0f)
+        if (penetration >= -margin)
         {
-            addContact(&result, pointA, pointB);
+            addContact(&result, pointA, pointB, SP_FEATURE_ID(SP_FEATURE_VERTEX(a->vertexB), SP_FEATURE_VERTEX(b->vertexA)));
         }
     }
 
@@ -515,9 +539,9 @@ EPA(const struct SupportPointContext* context, spMinkowskiPoint* m0, spMinkowski
 }
 
 static struct MinkowskiEdge 
-GJK(const struct SupportPointContext* context)
+GJK(const struct SupportPointContext* context, spCollisionCache* cache)
 {
-    NULLCHECK(context);
+    NULLCHECK(context); NULLCHECK(cache);
     /// get the shape pointers
     const spShape* shapeA = context->shapeA;
     const spShape* shapeB = context->shapeB;
@@ -526,18 +550,30 @@ GJK(const struct SupportPointContext* context)
     const spTransform* xfA = &shapeA->body->xf;
     const spTransform* xfB = &shapeB->body->xf;
 
-    /// generate an initial axis direction for support points
-    spVector cA = spxTransform(*xfA, spShapeGetCOM(shapeA));
-    spVector cB = spxTransform(*xfB, spShapeGetCOM(shapeB));
+    /// seed the simplex with the directions of last steps simplex
+    spVector dir0 = cache->dirs[0];
+    spVector dir1 = cache->dirs[1];
+    spMinkowskiPoint m0, m1;
+    if (cache->valid)
+    {
+        m0 = supportPoint(context, dir0);
+        m1 = supportPoint(context, dir1);
+    }
+
+    /// the pair is new or the cached edge collapsed, generate an initial axis from the centers of mass
+    if (cache->valid == spFalse || spvEqual(m0.v, m1.v))
+    {
+        spVector cA = spxTransform(*xfA, spShapeGetCOM(shapeA));
+        spVector cB = spxTransform(*xfB, spShapeGetCOM(shapeB));
 
-    /// calculate normal directions for support points
-    spVector normal = spSkew(spvSub(cA, cB));
-    spVector negate = spNegative(normal);
+        /// calculate normal directions for support points
+        dir0 = spSkew(spvSub(cA, cB));
+        dir1 = spNegative(dir0);
 
-    /// calculate initial minkowski points
-    /// TODO: cache points between frames
-    spMinkowskiPoint m0 = supportPoint(context, normal);
-    spMinkowskiPoint m1 = supportPoint(context, negate);
+        /// calculate initial minkowski points
+        m0 = supportPoint(context, dir0);
+        m1 = supportPoint(context, dir1);
+    }
 
     /// make sure the origin is always to the left of the edge
     if (spOriginToRight(m0.v, m1.v)) 
@@ -545,21 +581,39 @@ GJK(const struct SupportPointContext* context)
         spvSwap(&m0.v, &m1.v);
         spvSwap(&m0.a, &m1.a);
         spvSwap(&m0.b, &m1.b);
+        spvSwap(&dir0, &dir1);
     }
 
+    cache->valid = spTrue;
+    cache->separation = 0.0f;
+
     static const spInt max_iters = 16;
     for (spInt i = 0; i < max_iters; ++i)
     {
+        /// save the simplex edge so the next step can start from it
+        cache->dirs[0] = dir0;
+        cache->dirs[1] = dir1;
+        cache->iterations = i + 1;
+
         /// calculate a new direction for the next support point
         spVector dir = spSkew(spvSub(m0.v, m1.v));
 
         /// expand the simplex by generating a new support point
         spMinkowskiPoint m2 = supportPoint(context, dir);
 
+        /// no point of the minkowski difference is further along dir than the support point,
+        /// so its distance behind the origin is a lower bound on the distance between the shapes
+        spFloat length = spvLength(dir);
+        if (length > 0.0f)
+        {
+            cache->separation = spMax(cache->separation, -spDot(m2.v, dir) / length);
+        }
+
         /// check if the origin is inside of the 3-simplex or the new minkowski point is on origin
         if (spOriginToLeft(m1.v, m2.v) && spOriginToLeft(m2.v, m0.v) || spvEqual(m2.v, spVectorZero()))
         {
             /// the origin is in the simplex, pass the 3-simplex to EPA and generate contact info
+            cache->separation = 0.0f;
             return EPA(context, &m0, &m2, &m1);
         }
         else
@@ -578,10 +632,12 @@ GJK(const struct SupportPointContext* context)
                 if (m0isCloser)
                 {
                     m0 = m2;
+                    dir0 = dir;
                 }
                 else
                 {
                     m1 = m2;
+                    dir1 = dir;
                 }
             }
         }
@@ -594,7 +650,7 @@ GJK(const struct SupportPointContext* context)
 /// Collision functions
 
 static spCollisionResult 
-CircleToCircle(const spCircle* circleA, const spCircle* circleB)
+CircleToCircle(const spCircle* circleA, const spCircle* circleB, spCollisionCache* cache)
 {
     NULLCHECK(circleA); NULLCHECK(circleB);
     spCollisionResult result = spCollisionResultConstruct();
@@ -611,7 +667,7 @@ CircleToCircle(const spCircle* circleA, const spCircle* circleB)
     /// get the combined radius of the circles, and compute the distance between them
     spFloat radiusA = circleA->radius;
     spFloat radiusB = circleB->radius;
-    spFloat radius = radiusA + radiusB;
+    spFloat radius = radiusA + radiusB + (cache ? cache->margin : 0.0f);
     spFloat distance2 = spvLengthSquared(delta);
 
     /// if they overlap, generate contact info
@@ -626,22 +682,27 @@ CircleToCircle(const spCircle* circleA, const spCircle* circleB)
         spVector pointB = spvAdd(centerB, spvfMult(normal, -radiusB));
 
         /// add the contact
-        addContact(&result, pointA, pointB);
+        addContact(&result, pointA, pointB, 0);
+    }
+    else if (cache)
+    {
+        cache->separation = spsqrt(distance2);
     }
     return result;
 }
 
 static spCollisionResult 
-PolygonToCircle(const spPolygon* poly, const spCircle* circle)
+PolygonToCircle(const spPolygon* poly, const spCircle* circle, spCollisionCache* cache)
 {
     NULLCHECK(poly); NULLCHECK(circle);
     struct SupportPointContext context = { 
         (spShape*)poly, 
         (spShape*)circle, 
         (SupportPointFunc)extremalPointPoly, 
-        (SupportPointFunc)extremalPointCircle };
+        (SupportPointFunc)extremalPointCircle,
+        cache };
 
-    struct MinkowskiEdge mEdge = GJK(&context);
+    struct MinkowskiEdge mEdge = GJK(&context, cache);
 
     spCollisionResult result = spCollisionResultConstruct();
 
@@ -654,7 +715,7 @@ PolygonToCircle(const spPolygon* poly, const spCircle* circle)
     }
 
     /// check if they are potentially colliding
-    if (mEdge.distance + circle->radius + poly->radius >= 0.0f)
+    if (mEdge.distance + circle->radius + poly->radius + cache->margin >= 0.0f)
     {
         /// get the contact normal
         spVector normal = result.normal = mEdge.normal;
@@ -664,7 +725,7 @@ PolygonToCircle(const spPolygon* poly, const spCircle* circle)
         spVector pointB = spvAdd(points.b, spfvMult(circle->radius, spNegative(normal)));;
 
         /// add the contact to the collision result
-        addContact(&result, pointA, pointB);
+        addContact(&result, pointA, pointB, 0);
     }
 
     /// return the collision result
@@ -672,39 +733,40 @@ PolygonToCircle(const spPolygon* poly, const spCircle* circle)
 }
 
 static spCollisionResult 
-CircleToPolygon(const spCircle* circle, const spPolygon* poly)
+CircleToPolygon(const spCircle* circle, const spPolygon* poly, spCollisionCache* cache)
 {
     NULLCHECK(circle); NULLCHECK(poly);
-    spCollisionResult result = PolygonToCircle(poly, circle);
+    spCollisionResult result = PolygonToCircle(poly, circle, cache);
     invertContacts(&result);
     return result;
 }
 
 static spCollisionResult
-PolygonToPolygon2(const spPolygon* polyA, const spPolygon* polyB)
+PolygonToPolygon2(const spPolygon* polyA, const spPolygon* polyB, spCollisionCache* cache)
 {
     NULLCHECK(polyA); NULLCHECK(polyB);
     struct SupportPointContext context = { 
         (spShape*)polyA, 
         (spShape*)polyB, 
         (SupportPointFunc)extremalPointPoly,
-        (SupportPointFunc)extremalPointPoly };
+        (SupportPointFunc)extremalPointPoly,
+        cache };
 
-    struct MinkowskiEdge mEdge = GJK(&context);
+    struct MinkowskiEdge mEdge = GJK(&context, cache);
 
     /// check if they are are collising
-    if (mEdge.distance + polyA->radius + polyB->radius >= 0.0f)
+    if (mEdge.distance + polyA->radius + polyB->radius + cache->margin >= 0.0f)
     {
         /// get the two normal directions
         spVector normal = mEdge.normal;
         spVector negate = spNegative(normal);
 
         /// compute the extreme edges in the normals directions
-        Edge edgeA = extremalEdgePoly(polyA,  normal);
-        Edge edgeB = extremalEdgePoly(polyB,  negate);
+        Edge edgeA = extremalEdgePoly(polyA,  normal, cache->support + 0);
+        Edge edgeB = extremalEdgePoly(polyB,  negate, cache->support + 1);
 
         /// clip edges to get contact points
-        return clipEdges(&edgeA, &edgeB, &mEdge, polyA->radius, polyB->radius);
+        return clipEdges(&edgeA, &edgeB, &mEdge, polyA->radius, polyB->radius, cache->margin);
     }
 
     /// no collision occured
@@ -715,19 +777,20 @@ PolygonToPolygon2(const spPolygon* polyA, const spPolygon* polyB)
 }
 
 static spCollisionResult
-PolygonToPolygon(const spPolygon* polyA, const spPolygon* polyB)
+PolygonToPolygon(const spPolygon* polyA, const spPolygon* polyB, spCollisionCache* cache)
 {
     NULLCHECK(polyA); NULLCHECK(polyB);
     struct SupportPointContext context = { 
         (spShape*)polyA, 
         (spShape*)polyB, 
         (SupportPointFunc)extremalPointPoly,
-        (SupportPointFunc)extremalPointPoly };
+        (SupportPointFunc)extremalPointPoly,
+        cache };
 
-    struct MinkowskiEdge mEdge = GJK(&context);
+    struct MinkowskiEdge mEdge = GJK(&context, cache);
 
     /// check if they are are collising
-    if (mEdge.distance + polyA->radius + polyB->radius >= 0.0f)
+    if (mEdge.distance + polyA->radius + polyB->radius + cache->margin >= 0.0f)
     {
         /// get the two normal directions
         /// bias the normal slightly so we dont get swapping edge points due to floating point error (what a HEADACHE!)
@@ -735,11 +798,11 @@ PolygonToPolygon(const spPolygon* polyA, const spPolygon* polyB)
         spVector negate = spNegative(normal);
 
         /// compute the extreme edges in the normals directions
-        Edge edgeA = extremalEdgePoly(polyA,  normal);
-        Edge edgeB = extremalEdgePoly(polyB,  negate);
+        Edge edgeA = extremalEdgePoly(polyA,  normal, cache->support + 0);
+        Edge edgeB = extremalEdgePoly(polyB,  negate, cache->support + 1);
 
         /// clip edges to get contact points
-        return clipEdges(&edgeA, &edgeB, &mEdge, polyA->radius, polyB->radius);
+        return clipEdges(&edgeA, &edgeB, &mEdge, polyA->radius, polyB->radius, cache->margin);
     }
 
     /// no collision occured
@@ -750,17 +813,215 @@ PolygonToPolygon(const spPolygon* polyA, const spPolygon* polyB)
 }
 
 
+/// SAT
+
+static spFloat
+edgeSeparation(const spPolygon* poly1, const spPolygon* poly2, spInt edge)
+{
+    NULLCHECK(poly1); NULLCHECK(poly2);
+    spVector normal = poly1->worldEdges[edge].normal;
+    spVector vertex = poly1->worldEdges[edge].vertex;
+
+    /// find the deepest vertex of poly2 along the edge normal
+    spFloat minSeparation = SP_MAX_FLT;
+    for (spInt i = 0; i < poly2->count; ++i)
+    {
+        spFloat separation = spDot(normal, spvSub(poly2->worldEdges[i].vertex, vertex));
+        minSeparation = spMin(minSeparation, separation);
+    }
+    return minSeparation;
+}
+
+static spFloat
+maxSeparation(const spPolygon* poly1, const spPolygon* poly2, spFloat radius, spInt* edge)
+{
+    NULLCHECK(poly1); NULLCHECK(poly2); NULLCHECK(edge);
+    spFloat maxSeparation = -SP_MAX_FLT;
+    *edge = 0;
+
+    /// find the edge normal of poly1 with the largest separation
+    for (spInt i = 0; i < poly1->count; ++i)
+    {
+        spFloat separation = edgeSeparation(poly1, poly2, i);
+        if (separation > maxSeparation)
+        {
+            maxSeparation = separation;
+            *edge = i;
+        }
+
+        /// found a separating axis, the polygons cannot be colliding
+        if (separation > radius)
+        {
+            break;
+        }
+    }
+    return maxSeparation;
+}
+
+static Edge
+incidentEdge(const spPolygon* ref, const spPolygon* inc, spInt refEdge)
+{
+    NULLCHECK(ref); NULLCHECK(inc);
+    spVector normal = ref->worldEdges[refEdge].normal;
+
+    /// the incident edge is the edge most anti-parallel to the reference normal
+    spInt index = 0;
+    spFloat minDot = SP_MAX_FLT;
+    for (spInt i = 0; i < inc->count; ++i)
+    {
+        spFloat dot = spDot(normal, inc->worldEdges[i].normal);
+        if (dot < minDot)
+        {
+            minDot = dot;
+            index = i;
+        }
+    }
+
+    Edge edge;
+    edge.vertexA = index;
+    edge.vertexB = index+1 == inc->count ? 0 : index+1;
+    edge.a = inc->worldEdges[edge.vertexA].vertex;
+    edge.b = inc->worldEdges[edge.vertexB].vertex;
+    return edge;
+}
+
+static spInt
+clipSegment(spVector out[2], spUint outIds[2], const spVector in[2], const spUint inIds[2], spVector normal, spFloat offset, spUint clipId)
+{
+    /// keep the points behind the plane
+    spInt count = 0;
+    spFloat distance0 = spDot(normal, in[0]) - offset;
+    spFloat distance1 = spDot(normal, in[1]) - offset;
+    if (distance0 <= 0.0f) { outIds[count] = inIds[0]; out[count++] = in[0]; }
+    if (distance1 <= 0.0f) { outIds[count] = inIds[1]; out[count++] = in[1]; }
+
+    /// the points are on different sides of the plane, add the intersection. it comes from the planes vertex
+    if (distance0 * distance1 < 0.0f)
+    {
+        outIds[count] = clipId;
+        out[count++] = spvLerp(in[0], in[1], distance0 / (distance0 - distance1));
+    }
+    return count;
+}
+
 static spCollisionResult
-SegmentToCircle(const spSegment* segment, const spCircle* circle)
+PolygonToPolygonSAT(const spPolygon* polyA, const spPolygon* polyB, spCollisionCache* cache)
+{
+    NULLCHECK(polyA); NULLCHECK(polyB); NULLCHECK(cache);
+    /// rounded polygons need gjk/epa to get their corners right
+    if (polyA->radius > SP_SAT_MAX_RADIUS || polyB->radius > SP_SAT_MAX_RADIUS)
+    {
+        return PolygonToPolygon(polyA, polyB, cache);
+    }
+
+    spCollisionResult result = spCollisionResultConstruct();
+    spFloat radius = polyA->radius + polyB->radius + cache->margin;
+    cache->iterations = 0;
+
+    /// test last steps separating axis first, pairs that are still apart exit here
+    if (cache->axisEdge >= 0)
+    {
+        const spPolygon* poly1 = cache->axisShape == 0 ? polyA : polyB;
+        const spPolygon* poly2 = cache->axisShape == 0 ? polyB : polyA;
+        if (cache->axisEdge < poly1->count)
+        {
+            spFloat separation = edgeSeparation(poly1, poly2, cache->axisEdge);
+            if (separation > radius)
+            {
+                cache->separation = separation;
+                return result;
+            }
+        }
+    }
+
+    /// find the axis of least penetration on each polygon, stop on the first separating axis
+    spInt edgeA, edgeB;
+    spFloat separationA = maxSeparation(polyA, polyB, radius, &edgeA);
+    if (separationA > radius)
+    {
+        cache->axisShape = 0;
+        cache->axisEdge = edgeA;
+        cache->separation = separationA;
+        return result;
+    }
+
+    spFloat separationB = maxSeparation(polyB, polyA, radius, &edgeB);
+    if (separationB > radius)
+    {
+        cache->axisShape = 1;
+        cache->axisEdge = edgeB;
+        cache->separation = separationB;
+        return result;
+    }
+    cache->axisEdge = -1;
+
+    /// choose the reference face, prefer polygon a so the face doesnt flip between frames
+    static const spFloat tolerance = 0.005f;
+    spBool flip = separationB > separationA + tolerance;
+    const spPolygon* ref = flip ? polyB : polyA;
+    const spPolygon* inc = flip ? polyA : polyB;
+    spInt refEdge = flip ? edgeB : edgeA;
+
+    /// get the reference face in world space
+    spInt refVertex = refEdge+1 == ref->count ? 0 : refEdge+1;
+    spVector v1 = ref->worldEdges[refEdge].vertex;
+    spVector v2 = ref->worldEdges[refVertex].vertex;
+    spVector normal = ref->worldEdges[refEdge].normal;
+    spVector tangent = spNormal(spvSub(v2, v1));
+
+    /// clip the incident edge against the side planes of the reference face. points are identified by the
+    /// reference face and incident vertex, or by a reference vertex and the incident edge when they were clipped
+    Edge edge = incidentEdge(ref, inc, refEdge);
+    spVector points[2] = { edge.a, edge.b };
+    spUint ids[2] = { SP_FEATURE_ID(SP_FEATURE_EDGE(refEdge), SP_FEATURE_VERTEX(edge.vertexA)),
+                      SP_FEATURE_ID(SP_FEATURE_EDGE(refEdge), SP_FEATURE_VERTEX(edge.vertexB)) };
+    spVector clip1[2], clip2[2];
+    spUint clipIds1[2], clipIds2[2];
+    spUint sideId1 = SP_FEATURE_ID(SP_FEATURE_VERTEX(refEdge), SP_FEATURE_EDGE(edge.vertexA));
+    spUint sideId2 = SP_FEATURE_ID(SP_FEATURE_VERTEX(refVertex), SP_FEATURE_EDGE(edge.vertexA));
+    if (clipSegment(clip1, clipIds1, points, ids, spNegative(tangent), -spDot(tangent, v1), sideId1) < 2) return result;
+    if (clipSegment(clip2, clipIds2, clip1, clipIds1, tangent, spDot(tangent, v2), sideId2) < 2) return result;
+
+    /// the normal always points from a to b
+    spFloat radiusRef = flip ? polyB->radius : polyA->radius;
+    spFloat radiusInc = flip ? polyA->radius : polyB->radius;
+    result.normal = flip ? spNegative(normal) : normal;
+
+    /// keep the clipped points that are touching the reference face
+    spFloat offset = spDot(normal, v1);
+    for (spInt i = 0; i < 2; ++i)
+    {
+        spFloat separation = spDot(normal, clip2[i]) - offset;
+        if (separation > radius) continue;
+
+        /// project onto the reference face and push both points out to the polygons skins
+        spVector pointRef = spvAdd(clip2[i], spvfMult(normal, radiusRef - separation));
+        spVector pointInc = spvSub(clip2[i], spvfMult(normal, radiusInc));
+        if (flip)
+        {
+            /// ids are built reference first, swap them so shape a comes first
+            addContact(&result, pointInc, pointRef, (clipIds2[i] >> 16) | (clipIds2[i] << 16));
+        }
+        else
+        {
+            addContact(&result, pointRef, pointInc, clipIds2[i]);
+        }
+    }
+    return result;
+}
+
+static spCollisionResult
+SegmentToCircle(const spSegment* segment, const spCircle* circle, spCollisionCache* cache)
 {
     NULLCHECK(segment); NULLCHECK(circle);
     struct SupportPointContext context = { 
         (spShape*)segment, 
         (spShape*)circle, 
         (SupportPointFunc)extremalPointSegment, 
-        (SupportPointFunc)extremalPointCircle };
+        (SupportPointFunc)extremalPointCircle,
+        cache };
 
-    struct MinkowskiEdge mEdge = GJK(&context);
+    struct MinkowskiEdge mEdge = GJK(&context, cache);
 
     spCollisionResult result = spCollisionResultConstruct();
 
@@ -774,7 +1035,7 @@ SegmentToCircle(const spSegment* segment, const spCircle* circle)
     }
 
     /// check if they are potentially colliding
-    if (mEdge.distance + circle->radius + segment->radius >= 0.0f)
+    if (mEdge.distance + circle->radius + segment->radius + cache->margin >= 0.0f)
     {
         /// get the contact normal
         spVector normal = result.normal = mEdge.normal;
@@ -785,7 +1046,7 @@ SegmentToCircle(const spSegment* segment, const spCircle* circle)
         spVector pointB = spvAdd(points.b, spfvMult(circle->radius,  negate));
 
         /// add the contact to the collision result
-        addContact(&result, pointA, pointB);
+        addContact(&result, pointA, pointB, 0);
     }
 
     /// return the collision result
@@ -793,28 +1054,29 @@ SegmentToCircle(const spSegment* segment, const spCircle* circle)
 }
 
 static spCollisionResult
-CircleToSegment(const spCircle* circle, const spSegment* segment)
+CircleToSegment(const spCircle* circle, const spSegment* segment, spCollisionCache* cache)
 {
     NULLCHECK(circle); NULLCHECK(segment);
     /// collide the shapes and swap the contacts
-    spCollisionResult result = SegmentToCircle(segment, circle);
+    spCollisionResult result = SegmentToCircle(segment, circle, cache);
     invertContacts(&result);
     return result;
 }
 
 static spCollisionResult
-PolygonToSegment(const spPolygon* poly, const spSegment* segment)
+PolygonToSegment(const spPolygon* poly, const spSegment* segment, spCollisionCache* cache)
 {
     NULLCHECK(poly); NULLCHECK(segment);
     struct SupportPointContext context = { 
         (spShape*)poly, 
         (spShape*)segment, 
         (SupportPointFunc)extremalPointPoly,
-        (SupportPointFunc)extremalPointSegment };
+        (SupportPointFunc)extremalPointSegment,
+        cache };
 
-    struct MinkowskiEdge mEdge = GJK(&context);
+    struct MinkowskiEdge mEdge = GJK(&context, cache);
 
-    if (mEdge.distance + segment->radius + poly->radius >= 0.0f)
+    if (mEdge.distance + segment->radius + poly->radius + cache->margin >= 0.0f)
     {
         spVector normal = mEdge.normal;
         spVector negate = spNegative(normal);
@@ -825,7 +1087,7 @@ PolygonToSegment(const spPolygon* poly, const spSegment* segment)
         {
             spCollisionResult result = spCollisionResultConstruct();
             //vertexVertexCorrection(&mEdge, points);
-            if (mEdge.distance + segment->radius + poly->radius >= 0.0f)
+            if (mEdge.distance + segment->radius + poly->radius + cache->margin >= 0.0f)
             {
                 result.normal = mEdge.normal;
                 normal = mEdge.normal;
@@ -835,15 +1097,15 @@ PolygonToSegment(const spPolygon* poly, const spSegment* segment)
                 spVector pointB = spvAdd(points.b, spfvMult(segment->radius, negate));
 
                 /// add the contact to the collision result
-                addContact(&result, pointA, pointB);
+                addContact(&result, pointA, pointB, 0);
             }
             return result;
         }
 
         /// compute the world space edges in a normal direction
-        Edge edgeA = extremalEdgePoly(poly, normal);
+        Edge edgeA = extremalEdgePoly(poly, normal, cache->support + 0);
         Edge edgeB = extremalEdgeSegment(segment, negate);
-        return clipEdges(&edgeA, &edgeB, &mEdge, poly->radius, segment->radius);
+        return clipEdges(&edgeA, &edgeB, &mEdge, poly->radius, segment->radius, cache->margin);
     }
 
     /// there is no collision
@@ -854,23 +1116,217 @@ PolygonToSegment(const spPolygon* poly, const spSegment* segment)
 }
 
 static spCollisionResult
-SegmentToPolygon(const spSegment* segment, const spPolygon* poly)
+SegmentToPolygon(const spSegment* segment, const spPolygon* poly, spCollisionCache* cache)
 {
     NULLCHECK(segment); NULLCHECK(poly);
     /// collide the shapes and swap the contact info
-    spCollisionResult result = PolygonToSegment(poly, segment);
+    spCollisionResult result = PolygonToSegment(poly, segment, cache);
     invertContacts(&result);
     return result;
 }
 
 static spCollisionResult
-SegmentToSegment(const spSegment* segmentA, const spSegment* segmentB)
+SegmentToSegment(const spSegment* segmentA, const spSegment* segmentB, spCollisionCache* cache)
 {
     NULLCHECK(segmentA); NULLCHECK(segmentB);
     /// segments cannot collide
     return spCollisionResultConstruct();
 }
 
+static spFloat
+skinRadius(const spShape* shape)
+{
+    /// the radius collision functions add around the core point, polygon or segment
+    switch (shape->type)
+    {
+    case SP_SHAPE_CIRCLE:  return ((const spCircle*) shape)->radius;
+    case SP_SHAPE_POLYGON: return ((const spPolygon*) shape)->radius;
+    case SP_SHAPE_SEGMENT: return ((const spSegment*) shape)->radius;
+    default: return 0.0f;
+    }
+}
+
+static spFloat
+motionBound(const spShape* shape, const spVector origin, const spFloat angle)
+{
+    /// every point of the shape is within reach of the center of mass, so rotating moves it at most reach * angle
+    const spBody* body = shape->body;
+    return spDistance(body->p, origin) + spAbs(body->a - angle) * spShapeGetReach(shape);
+}
+
+static void
+cacheSeparation(const spShape* shapeA, const spShape* shapeB, spCollisionCache* cache, spFloat separation)
+{
+    /// remember the gap and where the bodies were, so later steps can tell how much of it could be closed
+    cache->separation = separation;
+    cache->origins[0] = shapeA->body->p;
+    cache->origins[1] = shapeB->body->p;
+    cache->angles[0] = shapeA->body->a;
+    cache->angles[1] = shapeB->body->a;
+}
+
+static spCollisionFunc
+collideFunc(const spShape* shapeA, const spShape* shapeB, const spCollisionCache* cache)
+{
+    /// the cache picks sat or gjk/epa for polygon pairs, so each world can choose without touching the shared table
+    if (cache->sat == spFalse && shapeA->type == SP_SHAPE_POLYGON && shapeB->type == SP_SHAPE_POLYGON)
+    {
+        return (spCollisionFunc)PolygonToPolygon;
+    }
+    return CollideFunc[shapeA->type][shapeB->type];
+}
+
+spCollisionResult
+spCollide(const spShape* shapeA, const spShape* shapeB, spCollisionCache* cache)
+{
+    NULLCHECK(shapeA); NULLCHECK(shapeB); NULLCHECK(cache);
+    cache->iterations = 0;
+
+    /// the bounding circles are apart, the shapes cannot be touching
+    spVector centerA = spxTransform(shapeA->body->xf, shapeA->bound.center);
+    spVector centerB = spxTransform(shapeB->body->xf, shapeB->bound.center);
+    spFloat gap = spDistance(centerA, centerB) - spShapeGetBoundRadius(shapeA) - spShapeGetBoundRadius(shapeB);
+    if (gap > cache->margin)
+    {
+        cacheSeparation(shapeA, shapeB, cache, gap);
+        return spCollisionResultConstruct();
+    }
+
+    /// the bodies have not moved far enough to close the gap measured on an earlier step
+    if (cache->separation > 0.0f)
+    {
+        spFloat motion = motionBound(shapeA, cache->origins[0], cache->angles[0]) +
+                         motionBound(shapeB, cache->origins[1], cache->angles[1]);
+        if (motion < cache->separation - cache->margin)
+        {
+            return spCollisionResultConstruct();
+        }
+    }
+
+    /// collide the shapes, the collision functions leave a lower bound on the distance between the cores
+    cache->separation = 0.0f;
+    spCollisionResult result = collideFunc(shapeA, shapeB, cache)(shapeA, shapeB, cache);
+    gap = cache->separation - skinRadius(shapeA) - skinRadius(shapeB);
+    cacheSeparation(shapeA, shapeB, cache, gap > 0.0f ? gap : 0.0f);
+
+    return result;
+}
+
+spFloat
+spCollisionDistance(const spShape* shapeA, const spShape* shapeB, spCollisionCache* cache)
+{
+    NULLCHECK(shapeA); NULLCHECK(shapeB); NULLCHECK(cache);
+    /// touching shapes have no gap, otherwise the collision function leaves a lower bound on the gap between the cores
+    spFloat margin = cache->margin;
+    cache->margin = 0.0f;
+    cache->separation = 0.0f;
+    spCollisionResult result = collideFunc(shapeA, shapeB, cache)(shapeA, shapeB, cache);
+    cache->margin = margin;
+
+    spFloat gap = cache->separation - skinRadius(shapeA) - skinRadius(shapeB);
+    return result.colliding == spFalse && gap > 0.0f ? gap : 0.0f;
+}
+
+void
+spCollideCircleBatch(const spContact* contacts, const spInt* indices, spInt count, spCollisionResult* results)
+{
+    NULLCHECK(contacts); NULLCHECK(indices); NULLCHECK(results);
+    spInt i = 0;
+
+#ifdef SP_SSE2
+    /// gather four pairs into structure of arrays, and collide them together
+    for (; i + 4 <= count; i += 4)
+    {
+        spFloat ax[4], ay[4], bx[4], by[4], ra[4], rb[4], rm[4];
+        for (spInt j = 0; j < 4; ++j)
+        {
+            const spContact* contact = contacts + indices[i+j];
+            const spCircle* circleA = (const spCircle*) contact->key.shapeA;
+            const spCircle* circleB = (const spCircle*) contact->key.shapeB;
+            spVector centerA = spxTransform(circleA->shape.body->xf, circleA->center);
+            spVector centerB = spxTransform(circleB->shape.body->xf, circleB->center);
+            ax[j] = centerA.x; ay[j] = centerA.y; ra[j] = circleA->radius;
+            bx[j] = centerB.x; by[j] = centerB.y; rb[j] = circleB->radius;
+            rm[j] = contact->cache.margin;
+        }
+
+        __m128 centerAx = _mm_loadu_ps(ax), centerAy = _mm_loadu_ps(ay), radiusA = _mm_loadu_ps(ra);
+        __m128 centerBx = _mm_loadu_ps(bx), centerBy = _mm_loadu_ps(by), radiusB = _mm_loadu_ps(rb);
+
+        /// same math as CircleToCircle, lane by lane
+        __m128 deltaX = _mm_sub_ps(centerBx, centerAx);
+        __m128 deltaY = _mm_sub_ps(centerBy, centerAy);
+        __m128 radius = _mm_add_ps(_mm_add_ps(radiusA, radiusB), _mm_loadu_ps(rm));
+        __m128 distance2 = _mm_add_ps(_mm_mul_ps(deltaX, deltaX), _mm_mul_ps(deltaY, deltaY));
+        spInt colliding = _mm_movemask_ps(_mm_cmplt_ps(distance2, _mm_mul_ps(radius, radius)));
+        if (colliding == 0)
+        {
+            for (spInt j = 0; j < 4; ++j)
+            {
+                results[indices[i+j]] = spCollisionResultConstruct();
+            }
+            continue;
+        }
+
+        /// concentric circles get an up normal, like the scalar version
+        __m128 pen = _mm_sqrt_ps(distance2);
+        __m128 zero = _mm_cmpeq_ps(pen, _mm_setzero_ps());
+        __m128 invPen = _mm_div_ps(_mm_set1_ps(1.0f), _mm_or_ps(pen, _mm_and_ps(zero, _mm_set1_ps(1.0f))));
+        __m128 normalX = _mm_andnot_ps(zero, _mm_mul_ps(deltaX, invPen));
+        __m128 normalY = _mm_or_ps(_mm_andnot_ps(zero, _mm_mul_ps(deltaY, invPen)), _mm_and_ps(zero, _mm_set1_ps(1.0f)));
+
+        spFloat nx[4], ny[4], pax[4], pay[4], pbx[4], pby[4];
+        _mm_storeu_ps(nx, normalX);
+        _mm_storeu_ps(ny, normalY);
+        _mm_storeu_ps(pax, _mm_add_ps(centerAx, _mm_mul_ps(normalX, radiusA)));
+        _mm_storeu_ps(pay, _mm_add_ps(centerAy, _mm_mul_ps(normalY, radiusA)));
+        _mm_storeu_ps(pbx, _mm_sub_ps(centerBx, _mm_mul_ps(normalX, radiusB)));
+        _mm_storeu_ps(pby, _mm_sub_ps(centerBy, _mm_mul_ps(normalY, radiusB)));
+
+        /// write each lane into its contacts result slot
+        for (spInt j = 0; j < 4; ++j)
+        {
+            spCollisionResult* result = results + indices[i+j];
+            *result = spCollisionResultConstruct();
+            if (colliding & (1 << j))
+            {
+                result->normal = spVectorConstruct(nx[j], ny[j]);
+                addContact(result, spVectorConstruct(pax[j], pay[j]), spVectorConstruct(pbx[j], pby[j]), 0);
+            }
+        }
+    }
+#endif
+
+    /// collide the rest one at a time
+    for (; i < count; ++i)
+    {
+        const spContact* contact = contacts + indices[i];
+        spCollisionCache cache = contact->cache;
+        results[indices[i]] = CircleToCircle((const spCircle*) contact->key.shapeA, (const spCircle*) contact->key.shapeB, &cache);
+    }
+}
+
+void
+spCollisionCacheInit(spCollisionCache* cache)
+{
+    NULLCHECK(cache);
+    cache->dirs[0] = spVectorZero();
+    cache->dirs[1] = spVectorZero();
+    cache->iterations = 0;
+    cache->support[0] = 0;
+    cache->support[1] = 0;
+    cache->axisShape = 0;
+    cache->axisEdge = -1;
+    cache->valid = spFalse;
+    cache->origins[0] = spVectorZero();
+    cache->origins[1] = spVectorZero();
+    cache->angles[0] = 0.0f;
+    cache->angles[1] = 0.0f;
+    cache->separation = 0.0f;
+    cache->margin = 0.0f;
+    cache->sat = spTrue;
+}
+
 /// collision functions
 spCollisionFunc CollideFunc[SP_SHAPE_COUNT][SP_SHAPE_COUNT] = 
 {
@@ -879,10 +1335,10 @@ spCollisionFunc CollideFunc[SP_SHAPE_COUNT][SP_SHAPE_COUNT] =
     (spCollisionFunc)CircleToSegment,
     
     (spCollisionFunc)PolygonToCircle,
-    (spCollisionFunc)PolygonToPolygon,
+    (spCollisionFunc)PolygonToPolygonSAT,
     (spCollisionFunc)PolygonToSegment,
 
     (spCollisionFunc)SegmentToCircle,
     (spCollisionFunc)SegmentToPolygon,
     (spCollisionFunc)SegmentToSegment
-};
\ No newline at end of file
+};
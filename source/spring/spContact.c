@@ -16,6 +16,7 @@ spContactPointInit(spContactPoint* point)
     point->eMassTang = 0.0f;
     point->bounce = 0.0f;
     point->bias   = 0.0f;
+    point->id     = 0;
 }
 
 void 
@@ -26,8 +27,7 @@ spContactInit(spContact* contact, const spContactKey key)
     spContactPointInit(contact->points+1);
     contact->key.shapeA = key.shapeA;
     contact->key.shapeB = key.shapeB;
-    contact->next        = NULL;
-    contact->prev        = NULL;
+    spCollisionCacheInit(&contact->cache);
     contact->normal      = spVectorZero();
     contact->restitution = 0.0f;
     contact->friction    = 0.0f;
@@ -98,12 +98,17 @@ spContactPreSolve(spContact* contact, const spFloat h)
         spFloat penetration = -spDot(spvAdd(spvSub(point->rB, point->rA), spvSub(b->p, a->p)), normal);
 
         /// compute bounce bias and velocity bias (compute position constraint)
-        point->bounce = spDot(relVelocity, normal) * -contact->restitution;
+        /// the bounce only lets the bodies leave faster, an approaching pair must never be allowed to keep approaching
+        spFloat approach = spDot(relVelocity, normal);
+        point->bounce = approach < 0.0f ? approach * contact->restitution : 0.0f;
         point->bias = (penetration > -spSlop) ? (-baumgarte * (penetration + -spSlop) / h) : 0.0f;
 
-        /// reset accumulated multipliers
-        point->lambdaAccumNorm = 0.0f;
-        point->lambdaAccumTang = 0.0f;
+        /// speculative points are still apart, they let the bodies approach by the gap this step but no further
+        if (penetration <= -spSlop)
+        {
+            point->bounce = 0.0f;
+            point->bias = -penetration / h;
+        }
     }
 }
 
@@ -118,18 +123,15 @@ spContactWarmStart(spContact* contact)
     {
         spContactPoint* point = contact->points+i;
 
-        /// compute the impulses
+        /// compute the impulses, the same way the solver does. the multipliers keep
+        /// accumulating from here, so the solver only applies the correction
         spVector impulse = spVectorConstruct(point->lambdaAccumNorm, point->lambdaAccumTang);
-        spVector impulseA = spRotate(contact->normal, impulse);
-        spVector impulseB = spNegative(impulseA);
+        spVector impulseB = spRotate(contact->normal, impulse);
+        spVector impulseA = spNegative(impulseB);
 
         /// apply the impulses
         spBodyApplyImpulse(a, point->rA, impulseA);
         spBodyApplyImpulse(b, point->rB, impulseB);
-
-        /// reset accumulated multipliers
-        point->lambdaAccumNorm = 0.0f;
-        point->lambdaAccumTang = 0.0f;
     }
 }
 
@@ -201,18 +203,6 @@ spContactGetKey(spContact* contact)
     return contact->key;
 }
 
-spContact* 
-spContactGetNext(spContact* contact)
-{
-    return contact->next;
-}
-
-spContact* 
-spContactGetPrev(spContact* contact)
-{
-    return contact->prev;
-}
-
 spVector 
 spContactGetNormal(spContact* contact)
 {
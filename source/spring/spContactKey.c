@@ -27,19 +27,6 @@ spContactKeyConstruct(spShape* shapeA, spShape* shapeB)
     return key;
 }
 
-spBool 
-spContactKeyExists(spContactKey key, spContact* contactList)
-{
-    for (spContact* contact = contactList; contact != NULL; contact = contact->next)
-    {
-        if (spContactKeyEqual(key, contact->key) == spTrue)
-        {
-            return spTrue;
-        }
-    }
-    return spFalse;
-}
-
 spBool 
 spContactKeyEqual(spContactKey keyA, spContactKey keyB)
 {
@@ -0,0 +1,430 @@
+#include "spContactSolver.h"
+#include "spBody.h"
+
+#ifdef SP_SSE2
+#include <emmintrin.h>
+#if (_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+static spVector
+pointVelocity(spBody* body, spVector r)
+{
+    return spvAdd(body->v, spfvCross(body->w, r));
+}
+
+static void
+applyImpulse(spSolverBody* body, spVector r, spVector impulse)
+{
+    body->v  = spvAdd(body->v, spvfMult(impulse, body->mInv));
+    body->w += body->iInv * spvCross(r, impulse);
+}
+
+#ifdef SP_SSE2
+static INLINE __m128
+negate(__m128 a)
+{
+    /// flip the sign bit, like unary minus does
+    return _mm_xor_ps(a, _mm_set1_ps(-0.0f));
+}
+
+static void
+gatherBodies(const spInt* index, spSolverBody* bodies, __m128* vx, __m128* vy, __m128* w)
+{
+    /// load v.x, v.y, w and mInv of each lane as one row, and transpose the rows into one vector per field
+    spSolverBody dummy = { { 0.0f, 0.0f }, 0.0f, 0.0f, 0.0f };
+    __m128 row0 = _mm_loadu_ps(&(index[0] != -1 ? bodies + index[0] : &dummy)->v.x);
+    __m128 row1 = _mm_loadu_ps(&(index[1] != -1 ? bodies + index[1] : &dummy)->v.x);
+    __m128 row2 = _mm_loadu_ps(&(index[2] != -1 ? bodies + index[2] : &dummy)->v.x);
+    __m128 row3 = _mm_loadu_ps(&(index[3] != -1 ? bodies + index[3] : &dummy)->v.x);
+    _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+    *vx = row0;
+    *vy = row1;
+    *w = row2;
+}
+
+static void
+scatterBodies(const spInt* index, spSolverBody* bodies, __m128 vx, __m128 vy, __m128 w, __m128 mInv)
+{
+    /// transpose back into rows, the mass goes back unchanged. lanes without a body write into the dummy
+    spSolverBody dummy;
+    _MM_TRANSPOSE4_PS(vx, vy, w, mInv);
+    _mm_storeu_ps(&(index[0] != -1 ? bodies + index[0] : &dummy)->v.x, vx);
+    _mm_storeu_ps(&(index[1] != -1 ? bodies + index[1] : &dummy)->v.x, vy);
+    _mm_storeu_ps(&(index[2] != -1 ? bodies + index[2] : &dummy)->v.x, w);
+    _mm_storeu_ps(&(index[3] != -1 ? bodies + index[3] : &dummy)->v.x, mInv);
+}
+#else
+static void
+unpackLane(spWideContactConstraint* wide, spInt lane, spContactConstraint* constraint)
+{
+    constraint->normal = spVectorConstruct(wide->normalX[lane], wide->normalY[lane]);
+    constraint->friction = wide->friction[lane];
+    constraint->indexA = wide->indexA[lane];
+    constraint->indexB = wide->indexB[lane];
+    constraint->count = wide->pointCount;
+    constraint->contact = -1;
+    for (spInt i = 0; i < 2; ++i)
+    {
+        spWideContactPoint* point = wide->points + i;
+        spContactConstraintPoint* cp = constraint->points + i;
+        cp->rA = spVectorConstruct(point->rAx[lane], point->rAy[lane]);
+        cp->rB = spVectorConstruct(point->rBx[lane], point->rBy[lane]);
+        cp->velocity = spVectorConstruct(point->vx[lane], point->vy[lane]);
+        cp->eMassNorm = point->eMassNorm[lane];
+        cp->eMassTang = point->eMassTang[lane];
+        cp->lambdaAccumNorm = point->lambdaNorm[lane];
+        cp->lambdaAccumTang = point->lambdaTang[lane];
+        cp->bounce = point->bounce[lane];
+        cp->bias = point->bias[lane];
+    }
+}
+
+static void
+storeLane(spWideContactConstraint* wide, spInt lane, spContactConstraint* constraint)
+{
+    for (spInt i = 0; i < 2; ++i)
+    {
+        wide->points[i].lambdaNorm[lane] = constraint->points[i].lambdaAccumNorm;
+        wide->points[i].lambdaTang[lane] = constraint->points[i].lambdaAccumTang;
+    }
+}
+#endif
+
+spBool
+spContactSolverHasSIMD()
+{
+#ifdef SP_SSE2
+#if (_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) ? spTrue : spFalse;
+#else
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0) return spFalse;
+    return (edx & bit_SSE2) ? spTrue : spFalse;
+#endif
+#else
+    return spFalse;
+#endif
+}
+
+void
+spSolverBodyLoad(spSolverBody* solverBody, spBody* body)
+{
+    solverBody->v = body->v;
+    solverBody->w = body->w;
+    solverBody->mInv = body->mInv;
+    solverBody->iInv = body->iInv;
+}
+
+void
+spSolverBodyStore(spSolverBody* solverBody, spBody* body)
+{
+    body->v = solverBody->v;
+    body->w = solverBody->w;
+}
+
+void
+spContactConstraintInit(spContactConstraint* constraint, spContact* contact, spInt index)
+{
+    spBody* a = contact->key.shapeA->body;
+    spBody* b = contact->key.shapeB->body;
+
+    constraint->normal = contact->normal;
+    constraint->friction = contact->friction;
+    constraint->indexA = a->islandNode;
+    constraint->indexB = b->islandNode;
+    constraint->count = contact->count;
+    constraint->contact = index;
+
+    for (spInt i = 0; i < contact->count; ++i)
+    {
+        spContactPoint* point = contact->points + i;
+        spContactConstraintPoint* cp = constraint->points + i;
+        cp->rA = point->rA;
+        cp->rB = point->rB;
+        cp->eMassNorm = point->eMassNorm;
+        cp->eMassTang = point->eMassTang;
+        cp->lambdaAccumNorm = point->lambdaAccumNorm;
+        cp->lambdaAccumTang = point->lambdaAccumTang;
+        cp->bounce = point->bounce;
+        cp->bias = point->bias;
+
+        /// static and kinematic bodies have no solver body, their velocity does not change during the solve
+        cp->velocity = spVectorZero();
+        if (constraint->indexA == -1) cp->velocity = spvSub(cp->velocity, pointVelocity(a, point->rA));
+        if (constraint->indexB == -1) cp->velocity = spvAdd(cp->velocity, pointVelocity(b, point->rB));
+    }
+}
+
+void
+spContactConstraintWarmStart(spContactConstraint* constraint, spSolverBody* bodies)
+{
+    /// bodies that are not dynamic use a body without velocity or mass, which soaks up their impulses
+    spSolverBody dummy = { { 0.0f, 0.0f }, 0.0f, 0.0f, 0.0f };
+    spSolverBody* a = constraint->indexA != -1 ? bodies + constraint->indexA : &dummy;
+    spSolverBody* b = constraint->indexB != -1 ? bodies + constraint->indexB : &dummy;
+
+    for (spInt i = 0; i < constraint->count; ++i)
+    {
+        spContactConstraintPoint* point = constraint->points + i;
+
+        /// compute the impulses, the same way the solver does
+        spVector impulse = spVectorConstruct(point->lambdaAccumNorm, point->lambdaAccumTang);
+        spVector impulseB = spRotate(constraint->normal, impulse);
+        spVector impulseA = spNegative(impulseB);
+
+        /// apply the impulses
+        applyImpulse(a, point->rA, impulseA);
+        applyImpulse(b, point->rB, impulseB);
+    }
+}
+
+void
+spContactConstraintSolve(spContactConstraint* constraint, spSolverBody* bodies)
+{
+    spSolverBody dummy = { { 0.0f, 0.0f }, 0.0f, 0.0f, 0.0f };
+    spSolverBody* a = constraint->indexA != -1 ? bodies + constraint->indexA : &dummy;
+    spSolverBody* b = constraint->indexB != -1 ? bodies + constraint->indexB : &dummy;
+
+    spVector normal  = constraint->normal;
+    spVector tangent = spSkew(normal);
+
+    for (spInt i = 0; i < constraint->count; ++i)
+    {
+        spContactConstraintPoint* point = constraint->points + i;
+
+        /// compute relative velocity between the two bodies
+        spVector rvA = spvAdd(a->v, spfvCross(a->w, point->rA));
+        spVector rvB = spvAdd(b->v, spfvCross(b->w, point->rB));
+        spVector relVelocity = spvAdd(spvSub(rvB, rvA), point->velocity);
+
+        /// lagrange multipliers used to compute the impulse
+        spFloat impulseNorm, impulseTang;
+
+        {
+            /// solve non-penetration constraint
+            spFloat Cdot = spDot(relVelocity, normal);
+            spFloat lambdaOld = point->lambdaAccumNorm;
+            spFloat lambda = -(Cdot + point->bounce + point->bias) * point->eMassNorm;
+
+            /// accumulate the multiplier and compute the impulse
+            point->lambdaAccumNorm = spMax(lambdaOld + lambda, 0.0f);
+            impulseNorm = point->lambdaAccumNorm - lambdaOld;
+        } {
+            /// solve friction constraint
+            spFloat Cdot = spDot(relVelocity, tangent);
+            spFloat lambdaMax = constraint->friction * point->lambdaAccumNorm;
+            spFloat lambdaOld = point->lambdaAccumTang;
+            spFloat lambda = -Cdot * point->eMassTang;
+
+            /// accumulate the multiplier and compute the impulse
+            point->lambdaAccumTang = spClamp(lambdaOld + lambda, -lambdaMax, lambdaMax);
+            impulseTang = point->lambdaAccumTang - lambdaOld;
+        }
+
+        /// compute and apply the body impulses
+        spVector impulseB = spRotate(normal, spVectorConstruct(impulseNorm, impulseTang));
+        spVector impulseA = spNegative(impulseB);
+        applyImpulse(a, point->rA, impulseA);
+        applyImpulse(b, point->rB, impulseB);
+    }
+}
+
+void
+spContactConstraintStore(spContactConstraint* constraint, spContact* contacts)
+{
+    spContact* contact = contacts + constraint->contact;
+    for (spInt i = 0; i < constraint->count; ++i)
+    {
+        contact->points[i].lambdaAccumNorm = constraint->points[i].lambdaAccumNorm;
+        contact->points[i].lambdaAccumTang = constraint->points[i].lambdaAccumTang;
+    }
+}
+
+void
+spWideContactConstraintInit(spWideContactConstraint* wide, spContactConstraint* constraints, spInt count, spSolverBody* bodies)
+{
+    NULLCHECK(wide); NULLCHECK(constraints);
+    spAssert(count > 0 && count <= SP_WIDE_LANES, "a wide constraint holds one to four constraints");
+
+    wide->count = count;
+    wide->pointCount = 0;
+    for (spInt j = 0; j < SP_WIDE_LANES; ++j)
+    {
+        spContactConstraint* constraint = j < count ? constraints + j : NULL;
+        spInt indexA = constraint ? constraint->indexA : -1;
+        spInt indexB = constraint ? constraint->indexB : -1;
+
+        wide->normalX[j] = constraint ? constraint->normal.x : 0.0f;
+        wide->normalY[j] = constraint ? constraint->normal.y : 0.0f;
+        wide->friction[j] = constraint ? constraint->friction : 0.0f;
+        wide->mInvA[j] = indexA != -1 ? bodies[indexA].mInv : 0.0f;
+        wide->iInvA[j] = indexA != -1 ? bodies[indexA].iInv : 0.0f;
+        wide->mInvB[j] = indexB != -1 ? bodies[indexB].mInv : 0.0f;
+        wide->iInvB[j] = indexB != -1 ? bodies[indexB].iInv : 0.0f;
+        wide->indexA[j] = indexA;
+        wide->indexB[j] = indexB;
+        if (constraint && constraint->count > wide->pointCount) wide->pointCount = constraint->count;
+
+        for (spInt i = 0; i < 2; ++i)
+        {
+            spWideContactPoint* point = wide->points + i;
+            spContactConstraintPoint* cp = constraint && i < constraint->count ? constraint->points + i : NULL;
+            point->rAx[j] = cp ? cp->rA.x : 0.0f;
+            point->rAy[j] = cp ? cp->rA.y : 0.0f;
+            point->rBx[j] = cp ? cp->rB.x : 0.0f;
+            point->rBy[j] = cp ? cp->rB.y : 0.0f;
+            point->vx[j] = cp ? cp->velocity.x : 0.0f;
+            point->vy[j] = cp ? cp->velocity.y : 0.0f;
+            point->eMassNorm[j] = cp ? cp->eMassNorm : 0.0f;
+            point->eMassTang[j] = cp ? cp->eMassTang : 0.0f;
+            point->lambdaNorm[j] = cp ? cp->lambdaAccumNorm : 0.0f;
+            point->lambdaTang[j] = cp ? cp->lambdaAccumTang : 0.0f;
+            point->bounce[j] = cp ? cp->bounce : 0.0f;
+            point->bias[j] = cp ? cp->bias : 0.0f;
+        }
+    }
+}
+
+void
+spWideContactConstraintWarmStart(spWideContactConstraint* wide, spSolverBody* bodies)
+{
+#ifdef SP_SSE2
+    __m128 vAx, vAy, wA, vBx, vBy, wB;
+    gatherBodies(wide->indexA, bodies, &vAx, &vAy, &wA);
+    gatherBodies(wide->indexB, bodies, &vBx, &vBy, &wB);
+
+    __m128 normalX = _mm_loadu_ps(wide->normalX), normalY = _mm_loadu_ps(wide->normalY);
+    __m128 mInvA = _mm_loadu_ps(wide->mInvA), iInvA = _mm_loadu_ps(wide->iInvA);
+    __m128 mInvB = _mm_loadu_ps(wide->mInvB), iInvB = _mm_loadu_ps(wide->iInvB);
+
+    for (spInt i = 0; i < wide->pointCount; ++i)
+    {
+        spWideContactPoint* point = wide->points + i;
+        __m128 rAx = _mm_loadu_ps(point->rAx), rAy = _mm_loadu_ps(point->rAy);
+        __m128 rBx = _mm_loadu_ps(point->rBx), rBy = _mm_loadu_ps(point->rBy);
+        __m128 impulseNorm = _mm_loadu_ps(point->lambdaNorm);
+        __m128 impulseTang = _mm_loadu_ps(point->lambdaTang);
+
+        /// same math as spContactConstraintWarmStart, lane by lane
+        __m128 impulseBx = _mm_sub_ps(_mm_mul_ps(normalX, impulseNorm), _mm_mul_ps(normalY, impulseTang));
+        __m128 impulseBy = _mm_add_ps(_mm_mul_ps(normalX, impulseTang), _mm_mul_ps(normalY, impulseNorm));
+        __m128 impulseAx = negate(impulseBx);
+        __m128 impulseAy = negate(impulseBy);
+
+        vAx = _mm_add_ps(vAx, _mm_mul_ps(impulseAx, mInvA));
+        vAy = _mm_add_ps(vAy, _mm_mul_ps(impulseAy, mInvA));
+        wA = _mm_add_ps(wA, _mm_mul_ps(iInvA, _mm_sub_ps(_mm_mul_ps(rAx, impulseAy), _mm_mul_ps(rAy, impulseAx))));
+        vBx = _mm_add_ps(vBx, _mm_mul_ps(impulseBx, mInvB));
+        vBy = _mm_add_ps(vBy, _mm_mul_ps(impulseBy, mInvB));
+        wB = _mm_add_ps(wB, _mm_mul_ps(iInvB, _mm_sub_ps(_mm_mul_ps(rBx, impulseBy), _mm_mul_ps(rBy, impulseBx))));
+    }
+
+    scatterBodies(wide->indexA, bodies, vAx, vAy, wA, mInvA);
+    scatterBodies(wide->indexB, bodies, vBx, vBy, wB, mInvB);
+#else
+    for (spInt j = 0; j < wide->count; ++j)
+    {
+        spContactConstraint constraint;
+        unpackLane(wide, j, &constraint);
+        spContactConstraintWarmStart(&constraint, bodies);
+    }
+#endif
+}
+
+void
+spWideContactConstraintSolve(spWideContactConstraint* wide, spSolverBody* bodies)
+{
+#ifdef SP_SSE2
+    __m128 vAx, vAy, wA, vBx, vBy, wB;
+    gatherBodies(wide->indexA, bodies, &vAx, &vAy, &wA);
+    gatherBodies(wide->indexB, bodies, &vBx, &vBy, &wB);
+
+    __m128 zero = _mm_setzero_ps();
+    __m128 normalX = _mm_loadu_ps(wide->normalX), normalY = _mm_loadu_ps(wide->normalY);
+    __m128 tangentX = negate(normalY), tangentY = normalX;
+    __m128 friction = _mm_loadu_ps(wide->friction);
+    __m128 mInvA = _mm_loadu_ps(wide->mInvA), iInvA = _mm_loadu_ps(wide->iInvA);
+    __m128 mInvB = _mm_loadu_ps(wide->mInvB), iInvB = _mm_loadu_ps(wide->iInvB);
+
+    for (spInt i = 0; i < wide->pointCount; ++i)
+    {
+        spWideContactPoint* point = wide->points + i;
+        __m128 rAx = _mm_loadu_ps(point->rAx), rAy = _mm_loadu_ps(point->rAy);
+        __m128 rBx = _mm_loadu_ps(point->rBx), rBy = _mm_loadu_ps(point->rBy);
+
+        /// compute relative velocity between the two bodies, the same way spContactConstraintSolve does
+        __m128 rvAx = _mm_add_ps(vAx, _mm_mul_ps(negate(wA), rAy));
+        __m128 rvAy = _mm_add_ps(vAy, _mm_mul_ps(wA, rAx));
+        __m128 rvBx = _mm_add_ps(vBx, _mm_mul_ps(negate(wB), rBy));
+        __m128 rvBy = _mm_add_ps(vBy, _mm_mul_ps(wB, rBx));
+        __m128 relX = _mm_add_ps(_mm_sub_ps(rvBx, rvAx), _mm_loadu_ps(point->vx));
+        __m128 relY = _mm_add_ps(_mm_sub_ps(rvBy, rvAy), _mm_loadu_ps(point->vy));
+
+        /// solve non-penetration constraint
+        __m128 Cdot = _mm_add_ps(_mm_mul_ps(relX, normalX), _mm_mul_ps(relY, normalY));
+        __m128 bias = _mm_add_ps(_mm_add_ps(Cdot, _mm_loadu_ps(point->bounce)), _mm_loadu_ps(point->bias));
+        __m128 lambda = _mm_mul_ps(negate(bias), _mm_loadu_ps(point->eMassNorm));
+        __m128 lambdaOld = _mm_loadu_ps(point->lambdaNorm);
+        __m128 lambdaNorm = _mm_max_ps(_mm_add_ps(lambdaOld, lambda), zero);
+        __m128 impulseNorm = _mm_sub_ps(lambdaNorm, lambdaOld);
+        _mm_storeu_ps(point->lambdaNorm, lambdaNorm);
+
+        /// solve friction constraint, clamped to the friction cone like spClamp does
+        __m128 CdotTang = _mm_add_ps(_mm_mul_ps(relX, tangentX), _mm_mul_ps(relY, tangentY));
+        __m128 lambdaMax = _mm_mul_ps(friction, lambdaNorm);
+        __m128 lambdaMin = negate(lambdaMax);
+        __m128 lambdaTangOld = _mm_loadu_ps(point->lambdaTang);
+        __m128 lambdaTang = _mm_add_ps(lambdaTangOld, _mm_mul_ps(negate(CdotTang), _mm_loadu_ps(point->eMassTang)));
+        __m128 below = _mm_cmplt_ps(lambdaTang, lambdaMin);
+        __m128 above = _mm_cmpgt_ps(lambdaTang, lambdaMax);
+        lambdaTang = _mm_or_ps(_mm_and_ps(below, lambdaMin), _mm_andnot_ps(below, lambdaTang));
+        lambdaTang = _mm_or_ps(_mm_and_ps(above, lambdaMax), _mm_andnot_ps(above, lambdaTang));
+        __m128 impulseTang = _mm_sub_ps(lambdaTang, lambdaTangOld);
+        _mm_storeu_ps(point->lambdaTang, lambdaTang);
+
+        /// compute and apply the body impulses
+        __m128 impulseBx = _mm_sub_ps(_mm_mul_ps(normalX, impulseNorm), _mm_mul_ps(normalY, impulseTang));
+        __m128 impulseBy = _mm_add_ps(_mm_mul_ps(normalX, impulseTang), _mm_mul_ps(normalY, impulseNorm));
+        __m128 impulseAx = negate(impulseBx);
+        __m128 impulseAy = negate(impulseBy);
+
+        vAx = _mm_add_ps(vAx, _mm_mul_ps(impulseAx, mInvA));
+        vAy = _mm_add_ps(vAy, _mm_mul_ps(impulseAy, mInvA));
+        wA = _mm_add_ps(wA, _mm_mul_ps(iInvA, _mm_sub_ps(_mm_mul_ps(rAx, impulseAy), _mm_mul_ps(rAy, impulseAx))));
+        vBx = _mm_add_ps(vBx, _mm_mul_ps(impulseBx, mInvB));
+        vBy = _mm_add_ps(vBy, _mm_mul_ps(impulseBy, mInvB));
+        wB = _mm_add_ps(wB, _mm_mul_ps(iInvB, _mm_sub_ps(_mm_mul_ps(rBx, impulseBy), _mm_mul_ps(rBy, impulseBx))));
+    }
+
+    scatterBodies(wide->indexA, bodies, vAx, vAy, wA, mInvA);
+    scatterBodies(wide->indexB, bodies, vBx, vBy, wB, mInvB);
+#else
+    for (spInt j = 0; j < wide->count; ++j)
+    {
+        spContactConstraint constraint;
+        unpackLane(wide, j, &constraint);
+        spContactConstraintSolve(&constraint, bodies);
+        storeLane(wide, j, &constraint);
+    }
+#endif
+}
+
+void
+spWideContactConstraintStore(spWideContactConstraint* wide, spContactConstraint* constraints)
+{
+    for (spInt j = 0; j < wide->count; ++j)
+    {
+        spContactConstraint* constraint = constraints + j;
+        for (spInt i = 0; i < constraint->count; ++i)
+        {
+            constraint->points[i].lambdaAccumNorm = wide->points[i].lambdaNorm[j];
+            constraint->points[i].lambdaAccumTang = wide->points[i].lambdaTang[j];
+        }
+    }
+}
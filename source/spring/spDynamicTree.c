@@ -0,0 +1,608 @@
+#include "spDynamicTree.h"
+
+/// size of the query stack before it spills onto the heap
+#define SP_TREE_STACK_SIZE 256
+
+/// context used while finding pairs for a moved proxy
+typedef struct
+{
+    spDynamicTree* tree;  ///< the tree being queried
+    spTreePairFunc func;  ///< pair callback
+    spLazyPointer context; ///< pair callback context
+    spInt queryId;        ///< the moved proxy
+} PairContext;
+
+static INLINE spBool
+isLeaf(const spTreeNode* node)
+{
+    return node->child1 == SP_NULL_NODE;
+}
+
+static INLINE spInt
+maxHeight(spInt a, spInt b)
+{
+    return a > b ? a : b;
+}
+
+static spInt
+allocateNode(spDynamicTree* tree)
+{
+    /// grow the node pool when the free list runs out
+    if (tree->freeList == SP_NULL_NODE)
+    {
+        spAssert(tree->count == tree->capacity, "the free list is empty but the pool is not full!");
+        tree->capacity = tree->capacity ? tree->capacity * 2 : 16;
+        tree->nodes = (spTreeNode*) spRealloc(tree->nodes, sizeof(spTreeNode) * tree->capacity);
+        NULLCHECK(tree->nodes);
+
+        /// link the new nodes into the free list
+        for (spInt i = tree->count; i < tree->capacity; ++i)
+        {
+            tree->nodes[i].parent = i + 1;
+            tree->nodes[i].height = -1;
+        }
+        tree->nodes[tree->capacity-1].parent = SP_NULL_NODE;
+        tree->freeList = tree->count;
+    }
+
+    /// pop a node off of the free list
+    spInt index = tree->freeList;
+    spTreeNode* node = tree->nodes + index;
+    tree->freeList = node->parent;
+    node->parent = SP_NULL_NODE;
+    node->child1 = SP_NULL_NODE;
+    node->child2 = SP_NULL_NODE;
+    node->height = 0;
+    node->data = NULL;
+    node->moved = spFalse;
+    tree->count++;
+
+    return index;
+}
+
+static void
+freeNode(spDynamicTree* tree, spInt index)
+{
+    spAssert(0 <= index && index < tree->capacity, "node index is out of range!");
+    tree->nodes[index].parent = tree->freeList;
+    tree->nodes[index].height = -1;
+    tree->freeList = index;
+    tree->count--;
+}
+
+static void
+bufferMove(spDynamicTree* tree, spInt proxyId)
+{
+    if (tree->moveCount == tree->moveCapacity)
+    {
+        tree->moveCapacity = tree->moveCapacity ? tree->moveCapacity * 2 : 16;
+        tree->moveBuffer = (spInt*) spRealloc(tree->moveBuffer, sizeof(spInt) * tree->moveCapacity);
+        NULLCHECK(tree->moveBuffer);
+    }
+    tree->moveBuffer[tree->moveCount++] = proxyId;
+    tree->nodes[proxyId].moved = spTrue;
+}
+
+static void
+unbufferMove(spDynamicTree* tree, spInt proxyId)
+{
+    for (spInt i = 0; i < tree->moveCount; ++i)
+    {
+        if (tree->moveBuffer[i] == proxyId)
+        {
+            tree->moveBuffer[i] = SP_NULL_NODE;
+        }
+    }
+}
+
+static void
+rotateNodes(spDynamicTree* tree, spInt iA)
+{
+    /// rotations swap a child of A with a grandchild of A if it lowers the summed
+    /// perimeter of the internal nodes below A. the aabb of A does not change.
+    /// e.g. swapping B and F turns A(B, C(F, G)) into A(F, C(B, G))
+
+    spTreeNode* nodes = tree->nodes;
+    spTreeNode* A = nodes + iA;
+    if (A->height < 2) return;
+
+    spInt iB = A->child1;
+    spInt iC = A->child2;
+    spTreeNode* B = nodes + iB;
+    spTreeNode* C = nodes + iC;
+
+    typedef enum { ROTATE_NONE, ROTATE_BF, ROTATE_BG, ROTATE_CD, ROTATE_CE } Rotation;
+    Rotation best = ROTATE_NONE;
+    spAABB aabbBG, aabbBF, aabbCE, aabbCD;
+
+    /// only internal nodes have a cost, leaves are free
+    spFloat areaB = isLeaf(B) ? 0.0f : spAABBPerimeter(&B->aabb);
+    spFloat areaC = isLeaf(C) ? 0.0f : spAABBPerimeter(&C->aabb);
+    spFloat bestCost = areaB + areaC;
+
+    if (isLeaf(C) == spFalse)
+    {
+        spTreeNode* F = nodes + C->child1;
+        spTreeNode* G = nodes + C->child2;
+
+        /// cost of swapping B and F
+        aabbBG = spAABBUnion(&B->aabb, &G->aabb);
+        spFloat costBF = areaB + spAABBPerimeter(&aabbBG);
+        if (costBF < bestCost)
+        {
+            best = ROTATE_BF;
+            bestCost = costBF;
+        }
+
+        /// cost of swapping B and G
+        aabbBF = spAABBUnion(&B->aabb, &F->aabb);
+        spFloat costBG = areaB + spAABBPerimeter(&aabbBF);
+        if (costBG < bestCost)
+        {
+            best = ROTATE_BG;
+            bestCost = costBG;
+        }
+    }
+
+    if (isLeaf(B) == spFalse)
+    {
+        spTreeNode* D = nodes + B->child1;
+        spTreeNode* E = nodes + B->child2;
+
+        /// cost of swapping C and D
+        aabbCE = spAABBUnion(&C->aabb, &E->aabb);
+        spFloat costCD = areaC + spAABBPerimeter(&aabbCE);
+        if (costCD < bestCost)
+        {
+            best = ROTATE_CD;
+            bestCost = costCD;
+        }
+
+        /// cost of swapping C and E
+        aabbCD = spAABBUnion(&C->aabb, &D->aabb);
+        spFloat costCE = areaC + spAABBPerimeter(&aabbCD);
+        if (costCE < bestCost)
+        {
+            best = ROTATE_CE;
+            bestCost = costCE;
+        }
+    }
+
+    switch (best)
+    {
+    case ROTATE_NONE:
+        break;
+
+    case ROTATE_BF:
+    {
+        spInt iF = C->child1;
+        spInt iG = C->child2;
+        A->child1 = iF;
+        C->child1 = iB;
+        B->parent = iC;
+        nodes[iF].parent = iA;
+        C->aabb = aabbBG;
+        C->height = 1 + maxHeight(B->height, nodes[iG].height);
+        A->height = 1 + maxHeight(C->height, nodes[iF].height);
+        break;
+    }
+
+    case ROTATE_BG:
+    {
+        spInt iF = C->child1;
+        spInt iG = C->child2;
+        A->child1 = iG;
+        C->child2 = iB;
+        B->parent = iC;
+        nodes[iG].parent = iA;
+        C->aabb = aabbBF;
+        C->height = 1 + maxHeight(B->height, nodes[iF].height);
+        A->height = 1 + maxHeight(C->height, nodes[iG].height);
+        break;
+    }
+
+    case ROTATE_CD:
+    {
+        spInt iD = B->child1;
+        spInt iE = B->child2;
+        A->child2 = iD;
+        B->child1 = iC;
+        C->parent = iB;
+        nodes[iD].parent = iA;
+        B->aabb = aabbCE;
+        B->height = 1 + maxHeight(C->height, nodes[iE].height);
+        A->height = 1 + maxHeight(B->height, nodes[iD].height);
+        break;
+    }
+
+    case ROTATE_CE:
+    {
+        spInt iD = B->child1;
+        spInt iE = B->child2;
+        A->child2 = iE;
+        B->child2 = iC;
+        C->parent = iB;
+        nodes[iE].parent = iA;
+        B->aabb = aabbCD;
+        B->height = 1 + maxHeight(C->height, nodes[iD].height);
+        A->height = 1 + maxHeight(B->height, nodes[iE].height);
+        break;
+    }
+    }
+}
+
+static void
+refitAncestors(spDynamicTree* tree, spInt index)
+{
+    /// walk back up the tree fixing the aabbs and heights, rotating as we go
+    while (index != SP_NULL_NODE)
+    {
+        spTreeNode* node = tree->nodes + index;
+        spTreeNode* child1 = tree->nodes + node->child1;
+        spTreeNode* child2 = tree->nodes + node->child2;
+
+        node->aabb = spAABBUnion(&child1->aabb, &child2->aabb);
+        node->height = 1 + maxHeight(child1->height, child2->height);
+
+        rotateNodes(tree, index);
+        index = node->parent;
+    }
+}
+
+static void
+insertLeaf(spDynamicTree* tree, spInt leaf)
+{
+    /// the tree is empty, the leaf becomes the root
+    if (tree->root == SP_NULL_NODE)
+    {
+        tree->root = leaf;
+        tree->nodes[leaf].parent = SP_NULL_NODE;
+        return;
+    }
+
+    /// find the best sibling for the leaf using the surface area heuristic
+    spAABB leafAABB = tree->nodes[leaf].aabb;
+    spInt index = tree->root;
+    while (isLeaf(tree->nodes + index) == spFalse)
+    {
+        spTreeNode* node = tree->nodes + index;
+        spTreeNode* child1 = tree->nodes + node->child1;
+        spTreeNode* child2 = tree->nodes + node->child2;
+
+        spFloat area = spAABBPerimeter(&node->aabb);
+        spAABB combined = spAABBUnion(&node->aabb, &leafAABB);
+        spFloat combinedArea = spAABBPerimeter(&combined);
+
+        /// cost of creating a new parent for this node and the new leaf
+        spFloat cost = 2.0f * combinedArea;
+
+        /// minimum cost of pushing the leaf further down the tree
+        spFloat inheritanceCost = 2.0f * (combinedArea - area);
+
+        /// cost of descending into child1
+        spAABB aabb1 = spAABBUnion(&child1->aabb, &leafAABB);
+        spFloat cost1 = spAABBPerimeter(&aabb1) + inheritanceCost;
+        if (isLeaf(child1) == spFalse)
+        {
+            cost1 -= spAABBPerimeter(&child1->aabb);
+        }
+
+        /// cost of descending into child2
+        spAABB aabb2 = spAABBUnion(&child2->aabb, &leafAABB);
+        spFloat cost2 = spAABBPerimeter(&aabb2) + inheritanceCost;
+        if (isLeaf(child2) == spFalse)
+        {
+            cost2 -= spAABBPerimeter(&child2->aabb);
+        }
+
+        /// descend according to the minimum cost
+        if (cost < cost1 && cost < cost2) break;
+        index = cost1 < cost2 ? node->child1 : node->child2;
+    }
+
+    /// create a new parent for the sibling and the leaf. this can grow the pool, so dont hold node pointers
+    spInt sibling = index;
+    spInt oldParent = tree->nodes[sibling].parent;
+    spInt newParent = allocateNode(tree);
+
+    spTreeNode* nodes = tree->nodes;
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].aabb = spAABBUnion(&leafAABB, &nodes[sibling].aabb);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].child1 = sibling;
+    nodes[newParent].child2 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent != SP_NULL_NODE)
+    {
+        /// the sibling was not the root
+        if (nodes[oldParent].child1 == sibling)
+        {
+            nodes[oldParent].child1 = newParent;
+        }
+        else
+        {
+            nodes[oldParent].child2 = newParent;
+        }
+    }
+    else
+    {
+        /// the sibling was the root
+        tree->root = newParent;
+    }
+
+    refitAncestors(tree, newParent);
+}
+
+static void
+removeLeaf(spDynamicTree* tree, spInt leaf)
+{
+    if (leaf == tree->root)
+    {
+        tree->root = SP_NULL_NODE;
+        return;
+    }
+
+    spTreeNode* nodes = tree->nodes;
+    spInt parent = nodes[leaf].parent;
+    spInt grandParent = nodes[parent].parent;
+    spInt sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+    if (grandParent != SP_NULL_NODE)
+    {
+        /// destroy the parent and connect the sibling to the grand parent
+        if (nodes[grandParent].child1 == parent)
+        {
+            nodes[grandParent].child1 = sibling;
+        }
+        else
+        {
+            nodes[grandParent].child2 = sibling;
+        }
+        nodes[sibling].parent = grandParent;
+        freeNode(tree, parent);
+
+        refitAncestors(tree, grandParent);
+    }
+    else
+    {
+        /// the parent was the root, the sibling becomes the new root
+        tree->root = sibling;
+        nodes[sibling].parent = SP_NULL_NODE;
+        freeNode(tree, parent);
+    }
+}
+
+static spBool
+queryPair(PairContext* pairs, spInt proxyId)
+{
+    spDynamicTree* tree = pairs->tree;
+
+    /// a proxy cannot pair with itself
+    if (proxyId == pairs->queryId) return spTrue;
+
+    /// both proxies moved, only report the pair once
+    if (tree->nodes[proxyId].moved && proxyId > pairs->queryId) return spTrue;
+
+    pairs->func(pairs->context, tree->nodes[pairs->queryId].data, tree->nodes[proxyId].data);
+    return spTrue;
+}
+
+void
+spDynamicTreeInit(spDynamicTree* tree)
+{
+    NULLCHECK(tree);
+    tree->nodes = NULL;
+    tree->moveBuffer = NULL;
+    tree->root = SP_NULL_NODE;
+    tree->count = 0;
+    tree->capacity = 0;
+    tree->freeList = SP_NULL_NODE;
+    tree->moveCount = 0;
+    tree->moveCapacity = 0;
+    tree->margin = SP_AABB_EXTENSION;
+}
+
+spDynamicTree
+spDynamicTreeConstruct()
+{
+    spDynamicTree tree;
+    spDynamicTreeInit(&tree);
+    return tree;
+}
+
+void
+spDynamicTreeDestroy(spDynamicTree* tree)
+{
+    NULLCHECK(tree);
+    if (tree->nodes)
+    {
+        spFree(&tree->nodes);
+    }
+    if (tree->moveBuffer)
+    {
+        spFree(&tree->moveBuffer);
+    }
+    spFloat margin = tree->margin;
+    spDynamicTreeInit(tree);
+    tree->margin = margin;
+}
+
+spInt
+spDynamicTreeInsertProxy(spDynamicTree* tree, const spAABB* aabb, spLazyPointer data)
+{
+    NULLCHECK(tree); NULLCHECK(aabb);
+    spInt proxyId = allocateNode(tree);
+
+    /// fatten the aabb so the proxy can move a little without being reinserted
+    tree->nodes[proxyId].aabb = spAABBFatten(aabb, tree->margin);
+    tree->nodes[proxyId].data = data;
+    tree->nodes[proxyId].height = 0;
+
+    insertLeaf(tree, proxyId);
+    bufferMove(tree, proxyId);
+
+    return proxyId;
+}
+
+void
+spDynamicTreeRemoveProxy(spDynamicTree* tree, spInt proxyId)
+{
+    NULLCHECK(tree);
+    spAssert(0 <= proxyId && proxyId < tree->capacity, "proxy id is out of range!");
+    spAssert(isLeaf(tree->nodes + proxyId), "proxy is not a leaf!");
+
+    if (tree->nodes[proxyId].moved)
+    {
+        unbufferMove(tree, proxyId);
+    }
+    removeLeaf(tree, proxyId);
+    freeNode(tree, proxyId);
+}
+
+spBool
+spDynamicTreeMoveProxy(spDynamicTree* tree, spInt proxyId, const spAABB* aabb)
+{
+    NULLCHECK(tree); NULLCHECK(aabb);
+    spAssert(0 <= proxyId && proxyId < tree->capacity, "proxy id is out of range!");
+    spAssert(isLeaf(tree->nodes + proxyId), "proxy is not a leaf!");
+
+    /// the proxy is still inside of its fat box, nothing to do
+    if (spAABBContains(&tree->nodes[proxyId].aabb, aabb))
+    {
+        return spFalse;
+    }
+
+    /// reinsert the proxy with a new fat box
+    removeLeaf(tree, proxyId);
+    tree->nodes[proxyId].aabb = spAABBFatten(aabb, tree->margin);
+    insertLeaf(tree, proxyId);
+
+    if (tree->nodes[proxyId].moved == spFalse)
+    {
+        bufferMove(tree, proxyId);
+    }
+    return spTrue;
+}
+
+void
+spDynamicTreeQuery(spDynamicTree* tree, const spAABB* aabb, spTreeQueryFunc func, spLazyPointer context)
+{
+    NULLCHECK(tree); NULLCHECK(aabb); NULLCHECK(func);
+    spInt  buffer[SP_TREE_STACK_SIZE];
+    spInt* stack = buffer;
+    spInt  capacity = SP_TREE_STACK_SIZE;
+    spInt  count = 0;
+
+    if (tree->root != SP_NULL_NODE)
+    {
+        stack[count++] = tree->root;
+    }
+
+    while (count > 0)
+    {
+        spInt index = stack[--count];
+        spTreeNode* node = tree->nodes + index;
+        if (spAABBOverlap(&node->aabb, aabb) == spFalse) continue;
+
+        if (isLeaf(node))
+        {
+            if (func(context, index) == spFalse) break;
+            continue;
+        }
+
+        /// spill the stack onto the heap if the tree is very deep
+        if (count + 2 > capacity)
+        {
+            spInt* grown = (spInt*) spMalloc(sizeof(spInt) * capacity * 2);
+            NULLCHECK(grown);
+            for (spInt i = 0; i < count; ++i)
+            {
+                grown[i] = stack[i];
+            }
+            if (stack != buffer)
+            {
+                spFree(&stack);
+            }
+            stack = grown;
+            capacity *= 2;
+        }
+        stack[count++] = node->child1;
+        stack[count++] = node->child2;
+    }
+
+    if (stack != buffer)
+    {
+        spFree(&stack);
+    }
+}
+
+void
+spDynamicTreeUpdatePairs(spDynamicTree* tree, spTreePairFunc func, spLazyPointer context)
+{
+    NULLCHECK(tree); NULLCHECK(func);
+    PairContext pairs;
+    pairs.tree = tree;
+    pairs.func = func;
+    pairs.context = context;
+
+    /// query the tree with each proxy that moved
+    for (spInt i = 0; i < tree->moveCount; ++i)
+    {
+        pairs.queryId = tree->moveBuffer[i];
+        if (pairs.queryId == SP_NULL_NODE) continue;
+
+        spAABB fatAABB = tree->nodes[pairs.queryId].aabb;
+        spDynamicTreeQuery(tree, &fatAABB, (spTreeQueryFunc)queryPair, &pairs);
+    }
+
+    /// reset the move buffer
+    for (spInt i = 0; i < tree->moveCount; ++i)
+    {
+        spInt proxyId = tree->moveBuffer[i];
+        if (proxyId == SP_NULL_NODE) continue;
+        tree->nodes[proxyId].moved = spFalse;
+    }
+    tree->moveCount = 0;
+}
+
+spBool
+spDynamicTreeTestOverlap(spDynamicTree* tree, spInt proxyA, spInt proxyB)
+{
+    NULLCHECK(tree);
+    spAssert(0 <= proxyA && proxyA < tree->capacity, "proxy id is out of range!");
+    spAssert(0 <= proxyB && proxyB < tree->capacity, "proxy id is out of range!");
+    return spAABBOverlap(&tree->nodes[proxyA].aabb, &tree->nodes[proxyB].aabb);
+}
+
+spAABB
+spDynamicTreeGetFatAABB(spDynamicTree* tree, spInt proxyId)
+{
+    NULLCHECK(tree);
+    spAssert(0 <= proxyId && proxyId < tree->capacity, "proxy id is out of range!");
+    return tree->nodes[proxyId].aabb;
+}
+
+spLazyPointer
+spDynamicTreeGetData(spDynamicTree* tree, spInt proxyId)
+{
+    NULLCHECK(tree);
+    spAssert(0 <= proxyId && proxyId < tree->capacity, "proxy id is out of range!");
+    return tree->nodes[proxyId].data;
+}
+
+spInt
+spDynamicTreeGetHeight(spDynamicTree* tree)
+{
+    NULLCHECK(tree);
+    return tree->root == SP_NULL_NODE ? 0 : tree->nodes[tree->root].height;
+}
+
+void
+spDynamicTreeSetMargin(spDynamicTree* tree, spFloat margin)
+{
+    NULLCHECK(tree);
+    spAssert(margin >= 0.0f, "the margin cannot be negative!");
+    tree->margin = margin;
+}
@@ -37,8 +37,8 @@ WarmStart(spGearJoint* joint)
     spBody* b = joint->constraint.bodyB;
 
     /// apply last timesteps impulse
-    a->w -= joint->lambdaAccum * a->iInv * joint->ratioInv;
-    b->w += joint->lambdaAccum * b->iInv;
+    spBodyApplyAngularImpulse(a, -joint->lambdaAccum * joint->ratioInv);
+    spBodyApplyAngularImpulse(b,  joint->lambdaAccum);
 
     /// reset the lagrange multipler
     joint->lambdaAccum = 0.0f;
@@ -58,8 +58,8 @@ Solve(spGearJoint* joint)
 
     /// compute and apply the impulse
     spFloat impulse = lambda;
-    a->w -= impulse * a->iInv * joint->ratioInv;
-    b->w += impulse * b->iInv;
+    spBodyApplyAngularImpulse(a, -impulse * joint->ratioInv);
+    spBodyApplyAngularImpulse(b,  impulse);
 }
 
 
@@ -0,0 +1,183 @@
+#include "spGraphColoring.h"
+#include "spConstraint.h"
+#include "spContact.h"
+#include "spBody.h"
+
+static spInt
+bodyNode(spBody* body)
+{
+    /// only dynamic bodies are written by the solver, joints like the mouse joint only have one body
+    return body ? body->islandNode : -1;
+}
+
+static spInt
+pickColor(spUint* masks, spInt nodeA, spInt nodeB)
+{
+    spUint used = (nodeA != -1 ? masks[nodeA] : 0) | (nodeB != -1 ? masks[nodeB] : 0);
+    for (spInt color = 0; color < SP_GRAPH_COLORS; ++color)
+    {
+        spUint bit = 1u << color;
+        if (used & bit) continue;
+
+        if (nodeA != -1) masks[nodeA] |= bit;
+        if (nodeB != -1) masks[nodeB] |= bit;
+        return color;
+    }
+    return SP_GRAPH_OVERFLOW;
+}
+
+static void
+reserve(spGraphColoring* coloring, spInt nodeCount, spInt contactCount, spInt jointCount)
+{
+    if (coloring->maskCapacity < nodeCount)
+    {
+        while (coloring->maskCapacity < nodeCount)
+        {
+            coloring->maskCapacity = coloring->maskCapacity ? coloring->maskCapacity * 2 : 64;
+        }
+        coloring->masks = (spUint*) spRealloc(coloring->masks, sizeof(spUint) * coloring->maskCapacity);
+        NULLCHECK(coloring->masks);
+    }
+    if (coloring->contactCapacity < contactCount)
+    {
+        while (coloring->contactCapacity < contactCount)
+        {
+            coloring->contactCapacity = coloring->contactCapacity ? coloring->contactCapacity * 2 : 64;
+        }
+        coloring->contacts = (spInt*) spRealloc(coloring->contacts, sizeof(spInt) * coloring->contactCapacity);
+        NULLCHECK(coloring->contacts);
+    }
+    if (coloring->jointCapacity < jointCount)
+    {
+        while (coloring->jointCapacity < jointCount)
+        {
+            coloring->jointCapacity = coloring->jointCapacity ? coloring->jointCapacity * 2 : 16;
+        }
+        coloring->joints = (spConstraint**) spRealloc(coloring->joints, sizeof(spConstraint*) * coloring->jointCapacity);
+        NULLCHECK(coloring->joints);
+    }
+    if (coloring->colorCapacity < contactCount + jointCount)
+    {
+        while (coloring->colorCapacity < contactCount + jointCount)
+        {
+            coloring->colorCapacity = coloring->colorCapacity ? coloring->colorCapacity * 2 : 64;
+        }
+        coloring->colorOf = (spInt*) spRealloc(coloring->colorOf, sizeof(spInt) * coloring->colorCapacity);
+        NULLCHECK(coloring->colorOf);
+    }
+}
+
+void
+spGraphColoringInit(spGraphColoring* coloring)
+{
+    NULLCHECK(coloring);
+    for (spInt i = 0; i <= SP_GRAPH_OVERFLOW; ++i)
+    {
+        spGraphColor* color = coloring->colors + i;
+        color->contactStart = color->contactCount = color->jointStart = color->jointCount = 0;
+    }
+    coloring->contacts = NULL;
+    coloring->joints = NULL;
+    coloring->masks = NULL;
+    coloring->colorOf = NULL;
+    coloring->contactCapacity = 0;
+    coloring->jointCapacity = 0;
+    coloring->maskCapacity = 0;
+    coloring->colorCapacity = 0;
+}
+
+spGraphColoring
+spGraphColoringConstruct()
+{
+    spGraphColoring coloring;
+    spGraphColoringInit(&coloring);
+    return coloring;
+}
+
+void
+spGraphColoringDestroy(spGraphColoring* coloring)
+{
+    NULLCHECK(coloring);
+    if (coloring->contacts)
+    {
+        spFree(&coloring->contacts);
+    }
+    if (coloring->joints)
+    {
+        spFree(&coloring->joints);
+    }
+    if (coloring->masks)
+    {
+        spFree(&coloring->masks);
+    }
+    if (coloring->colorOf)
+    {
+        spFree(&coloring->colorOf);
+    }
+    spGraphColoringInit(coloring);
+}
+
+void
+spGraphColoringBuild(spGraphColoring* coloring, spIslandGraph* graph, spIsland* island, spContact* contacts)
+{
+    NULLCHECK(coloring); NULLCHECK(graph); NULLCHECK(island);
+    reserve(coloring, graph->bodyCount, island->contactCount, island->jointCount);
+
+    spBody** bodies = graph->bodies + island->bodyStart;
+    spInt* islandContacts = graph->contacts + island->contactStart;
+    spConstraint** islandJoints = graph->joints + island->jointStart;
+    spInt* colorOf = coloring->colorOf;
+    spGraphColor* colors = coloring->colors;
+
+    /// only the islands own bodies are looked at, so only their masks are cleared
+    for (spInt i = 0; i < island->bodyCount; ++i)
+    {
+        coloring->masks[bodies[i]->islandNode] = 0;
+    }
+    for (spInt i = 0; i <= SP_GRAPH_OVERFLOW; ++i)
+    {
+        colors[i].contactCount = colors[i].jointCount = 0;
+    }
+
+    /// greedy first fit, each constraint takes the first color its bodies are free in
+    for (spInt i = 0; i < island->jointCount; ++i)
+    {
+        spConstraint* joint = islandJoints[i];
+        colorOf[i] = pickColor(coloring->masks, bodyNode(joint->bodyA), bodyNode(joint->bodyB));
+        colors[colorOf[i]].jointCount++;
+    }
+
+    /// joints and contacts are solved in separate passes, so the contacts start over with every color
+    for (spInt i = 0; i < island->bodyCount; ++i)
+    {
+        coloring->masks[bodies[i]->islandNode] = 0;
+    }
+    for (spInt i = 0; i < island->contactCount; ++i)
+    {
+        spContact* contact = contacts + islandContacts[i];
+        spInt color = pickColor(coloring->masks, contact->key.shapeA->body->islandNode, contact->key.shapeB->body->islandNode);
+        colorOf[island->jointCount + i] = color;
+        colors[color].contactCount++;
+    }
+
+    /// give each color its range of the lists, then fill them in island order
+    spInt contactStart = 0, jointStart = 0;
+    for (spInt i = 0; i <= SP_GRAPH_OVERFLOW; ++i)
+    {
+        colors[i].contactStart = contactStart;
+        colors[i].jointStart = jointStart;
+        contactStart += colors[i].contactCount;
+        jointStart += colors[i].jointCount;
+        colors[i].contactCount = colors[i].jointCount = 0;
+    }
+    for (spInt i = 0; i < island->jointCount; ++i)
+    {
+        spGraphColor* color = colors + colorOf[i];
+        coloring->joints[color->jointStart + color->jointCount++] = islandJoints[i];
+    }
+    for (spInt i = 0; i < island->contactCount; ++i)
+    {
+        spGraphColor* color = colors + colorOf[island->jointCount + i];
+        coloring->contacts[color->contactStart + color->contactCount++] = islandContacts[i];
+    }
+}
@@ -0,0 +1,279 @@
+#include "spIsland.h"
+#include "spConstraint.h"
+#include "spContact.h"
+#include "spBody.h"
+
+static spInt
+findRoot(spInt* parent, spInt node)
+{
+    /// path halving, every other node on the path is pointed at its grandparent
+    while (parent[node] != node)
+    {
+        parent[node] = parent[parent[node]];
+        node = parent[node];
+    }
+    return node;
+}
+
+static void
+unite(spInt* parent, spInt nodeA, spInt nodeB)
+{
+    /// the smaller node is always the root, so an islands root is its first body
+    spInt rootA = findRoot(parent, nodeA);
+    spInt rootB = findRoot(parent, nodeB);
+    if (rootA < rootB)
+    {
+        parent[rootB] = rootA;
+    }
+    else if (rootB < rootA)
+    {
+        parent[rootA] = rootB;
+    }
+}
+
+static spInt
+contactNode(spContact* contact)
+{
+    /// the island of a contact is the island of its dynamic body, -1 if neither body is dynamic
+    spInt nodeA = contact->key.shapeA->body->islandNode;
+    return nodeA != -1 ? nodeA : contact->key.shapeB->body->islandNode;
+}
+
+static spInt
+bodyNode(spBody* body)
+{
+    /// joints like the mouse joint only have one body
+    return body ? body->islandNode : -1;
+}
+
+static spInt
+jointNode(spConstraint* joint)
+{
+    spInt nodeA = bodyNode(joint->bodyA);
+    return nodeA != -1 ? nodeA : bodyNode(joint->bodyB);
+}
+
+static void
+reserve(spIslandGraph* graph, spInt bodyCount, spInt contactCount, spInt jointCount)
+{
+    if (graph->bodyCapacity < bodyCount)
+    {
+        while (graph->bodyCapacity < bodyCount)
+        {
+            graph->bodyCapacity = graph->bodyCapacity ? graph->bodyCapacity * 2 : 64;
+        }
+        graph->islands = (spIsland*) spRealloc(graph->islands, sizeof(spIsland) * graph->bodyCapacity);
+        graph->bodies = (spBody**) spRealloc(graph->bodies, sizeof(spBody*) * graph->bodyCapacity);
+        graph->nodes = (spBody**) spRealloc(graph->nodes, sizeof(spBody*) * graph->bodyCapacity);
+        graph->parent = (spInt*) spRealloc(graph->parent, sizeof(spInt) * graph->bodyCapacity);
+        graph->islandOf = (spInt*) spRealloc(graph->islandOf, sizeof(spInt) * graph->bodyCapacity);
+        NULLCHECK(graph->islands); NULLCHECK(graph->bodies); NULLCHECK(graph->nodes);
+        NULLCHECK(graph->parent); NULLCHECK(graph->islandOf);
+    }
+    if (graph->contactCapacity < contactCount)
+    {
+        while (graph->contactCapacity < contactCount)
+        {
+            graph->contactCapacity = graph->contactCapacity ? graph->contactCapacity * 2 : 64;
+        }
+        graph->contacts = (spInt*) spRealloc(graph->contacts, sizeof(spInt) * graph->contactCapacity);
+        NULLCHECK(graph->contacts);
+    }
+    if (graph->jointCapacity < jointCount)
+    {
+        while (graph->jointCapacity < jointCount)
+        {
+            graph->jointCapacity = graph->jointCapacity ? graph->jointCapacity * 2 : 16;
+        }
+        graph->joints = (spConstraint**) spRealloc(graph->joints, sizeof(spConstraint*) * graph->jointCapacity);
+        NULLCHECK(graph->joints);
+    }
+}
+
+void
+spIslandGraphInit(spIslandGraph* graph)
+{
+    NULLCHECK(graph);
+    graph->islands = NULL;
+    graph->bodies = NULL;
+    graph->contacts = NULL;
+    graph->joints = NULL;
+    graph->nodes = NULL;
+    graph->parent = NULL;
+    graph->islandOf = NULL;
+    graph->islandCount = 0;
+    graph->bodyCount = 0;
+    graph->contactCount = 0;
+    graph->jointCount = 0;
+    graph->bodyCapacity = 0;
+    graph->contactCapacity = 0;
+    graph->jointCapacity = 0;
+}
+
+spIslandGraph
+spIslandGraphConstruct()
+{
+    spIslandGraph graph;
+    spIslandGraphInit(&graph);
+    return graph;
+}
+
+void
+spIslandGraphDestroy(spIslandGraph* graph)
+{
+    NULLCHECK(graph);
+    if (graph->bodyCapacity)
+    {
+        spFree(&graph->islands);
+        spFree(&graph->bodies);
+        spFree(&graph->nodes);
+        spFree(&graph->parent);
+        spFree(&graph->islandOf);
+    }
+    if (graph->contacts)
+    {
+        spFree(&graph->contacts);
+    }
+    if (graph->joints)
+    {
+        spFree(&graph->joints);
+    }
+    spIslandGraphInit(graph);
+}
+
+void
+spIslandGraphBuild(spIslandGraph* graph, spBody* bodyList, spConstraint* jointList, spContact* contacts, spInt contactCount)
+{
+    NULLCHECK(graph);
+
+    /// every dynamic body is a node, the others are left out so they do not join islands together
+    spInt nodeCount = 0;
+    spInt jointCount = 0;
+    for (spBody* body = bodyList; body; body = body->next)
+    {
+        body->islandNode = body->type == SP_BODY_DYNAMIC ? nodeCount++ : -1;
+    }
+    for (spConstraint* joint = jointList; joint; joint = joint->next)
+    {
+        ++jointCount;
+    }
+    reserve(graph, nodeCount, contactCount, jointCount);
+
+    spInt* parent = graph->parent;
+    spInt* islandOf = graph->islandOf;
+    for (spBody* body = bodyList; body; body = body->next)
+    {
+        if (body->islandNode == -1) continue;
+        graph->nodes[body->islandNode] = body;
+        parent[body->islandNode] = body->islandNode;
+    }
+
+    /// join the bodies of every touching contact and every joint
+    for (spInt i = 0; i < contactCount; ++i)
+    {
+        spContact* contact = contacts + i;
+        spInt nodeA = contact->key.shapeA->body->islandNode;
+        spInt nodeB = contact->key.shapeB->body->islandNode;
+        if (contact->count > 0 && nodeA != -1 && nodeB != -1)
+        {
+            unite(parent, nodeA, nodeB);
+        }
+    }
+    for (spConstraint* joint = jointList; joint; joint = joint->next)
+    {
+        spInt nodeA = bodyNode(joint->bodyA);
+        spInt nodeB = bodyNode(joint->bodyB);
+        if (nodeA != -1 && nodeB != -1)
+        {
+            unite(parent, nodeA, nodeB);
+        }
+    }
+
+    /// number the islands by their roots, a root always comes before the rest of its island
+    spIsland* islands = graph->islands;
+    graph->islandCount = 0;
+    for (spInt i = 0; i < nodeCount; ++i)
+    {
+        spInt root = findRoot(parent, i);
+        if (root == i)
+        {
+            spIsland* island = islands + graph->islandCount;
+            island->bodyCount = island->contactCount = island->jointCount = 0;
+            island->awake = spFalse;
+            islandOf[i] = graph->islandCount++;
+        }
+        else
+        {
+            islandOf[i] = islandOf[root];
+        }
+    }
+
+    /// count what goes in each island
+    for (spInt i = 0; i < nodeCount; ++i)
+    {
+        islands[islandOf[i]].bodyCount++;
+    }
+    for (spInt i = 0; i < contactCount; ++i)
+    {
+        spInt node = contactNode(contacts + i);
+        if (contacts[i].count > 0 && node != -1)
+        {
+            islands[islandOf[node]].contactCount++;
+        }
+    }
+    for (spConstraint* joint = jointList; joint; joint = joint->next)
+    {
+        spInt node = jointNode(joint);
+        if (node != -1)
+        {
+            islands[islandOf[node]].jointCount++;
+        }
+    }
+
+    /// give each island its range of the lists, then fill them in order
+    spInt bodyStart = 0, contactStart = 0, jointStart = 0;
+    for (spInt i = 0; i < graph->islandCount; ++i)
+    {
+        spIsland* island = islands + i;
+        island->bodyStart = bodyStart;
+        island->contactStart = contactStart;
+        island->jointStart = jointStart;
+        bodyStart += island->bodyCount;
+        contactStart += island->contactCount;
+        jointStart += island->jointCount;
+        island->bodyCount = island->contactCount = island->jointCount = 0;
+    }
+    graph->bodyCount = bodyStart;
+    graph->contactCount = contactStart;
+    graph->jointCount = jointStart;
+
+    for (spInt i = 0; i < nodeCount; ++i)
+    {
+        spIsland* island = islands + islandOf[i];
+        graph->bodies[island->bodyStart + island->bodyCount++] = graph->nodes[i];
+    }
+    for (spInt i = 0; i < contactCount; ++i)
+    {
+        spInt node = contactNode(contacts + i);
+        if (contacts[i].count > 0 && node != -1)
+        {
+            spIsland* island = islands + islandOf[node];
+            graph->contacts[island->contactStart + island->contactCount++] = i;
+        }
+    }
+    for (spConstraint* joint = jointList; joint; joint = joint->next)
+    {
+        spInt node = jointNode(joint);
+        if (node != -1)
+        {
+            spIsland* island = islands + islandOf[node];
+            graph->joints[island->jointStart + island->jointCount++] = joint;
+        }
+    }
+}
+
+spInt
+spIslandGraphGetIslandCount(spIslandGraph* graph)
+{
+    return graph->islandCount;
+}
@@ -26,8 +26,8 @@ WarmStart(spMotorJoint* joint)
     spBody* a = joint->constraint.bodyA;
     spBody* b = joint->constraint.bodyB;
 
-    a->w -= joint->lambdaAccum * a->iInv;
-    b->w += joint->lambdaAccum * b->iInv;
+    spBodyApplyAngularImpulse(a, -joint->lambdaAccum);
+    spBodyApplyAngularImpulse(b,  joint->lambdaAccum);
 
     /// clear lagrange multiplier
     joint->lambdaAccum = 0.0f;
@@ -50,8 +50,8 @@ Solve(spMotorJoint* joint)
     spFloat impulse = joint->lambdaAccum - lambdaPrev;
 
     /// apply the impulse
-    a->w -= impulse * a->iInv;
-    b->w += impulse * b->iInv;
+    spBodyApplyAngularImpulse(a, -impulse);
+    spBodyApplyAngularImpulse(b,  impulse);
 }
 
 void 
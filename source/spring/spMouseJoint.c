@@ -201,6 +201,13 @@ void
 spMouseJointSetTarget(spConstraint* constraint, spVector target)
 {
     mouseJoint->target = target;
+
+    /// dragging a sleeping body wakes it up
+    spBody* a = mouseJoint->constraint.bodyA;
+    if (a && a->awake == spFalse)
+    {
+        spBodySetAwake(a, spTrue);
+    }
 }
 
 void 
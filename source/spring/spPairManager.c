@@ -0,0 +1,191 @@
+#include "spPairManager.h"
+
+#define SP_EMPTY_SLOT (-1)
+
+static spUint
+hashKey(spContactKey key)
+{
+    /// keys are sorted, so (a, b) and (b, a) hash the same
+    size_t a = (size_t)key.shapeA;
+    size_t b = (size_t)key.shapeB;
+    spUint hash = (spUint)(a >> 3) * 0x9E3779B1u ^ (spUint)(b >> 3) * 0x85EBCA77u;
+
+    /// mix the high bits down, the table is indexed with the low bits
+    hash ^= hash >> 16;
+    hash *= 0x7FEB352Du;
+    hash ^= hash >> 15;
+    return hash;
+}
+
+static spInt
+findSlot(spPairManager* manager, spContactKey key)
+{
+    spInt mask = manager->tableSize - 1;
+    spInt slot = (spInt)(hashKey(key) & (spUint)mask);
+
+    /// linear probe until the key or an empty slot is found
+    while (manager->table[slot] != SP_EMPTY_SLOT)
+    {
+        if (spContactKeyEqual(manager->contacts[manager->table[slot]].key, key))
+        {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static void
+growTable(spPairManager* manager)
+{
+    spInt size = manager->tableSize ? manager->tableSize * 2 : 64;
+    spFree(&manager->table);
+    manager->table = (spInt*) spMalloc(sizeof(spInt) * size);
+    NULLCHECK(manager->table);
+    manager->tableSize = size;
+
+    for (spInt i = 0; i < size; ++i)
+    {
+        manager->table[i] = SP_EMPTY_SLOT;
+    }
+
+    /// rehash every contact
+    for (spInt i = 0; i < manager->count; ++i)
+    {
+        manager->table[findSlot(manager, manager->contacts[i].key)] = i;
+    }
+}
+
+static void
+removeSlot(spPairManager* manager, spInt slot)
+{
+    spInt mask = manager->tableSize - 1;
+    spInt index = manager->table[slot];
+
+    /// backward shift deletion, pull later entries of the probe chain into the hole
+    spInt hole = slot;
+    spInt next = (hole + 1) & mask;
+    while (manager->table[next] != SP_EMPTY_SLOT)
+    {
+        spInt home = (spInt)(hashKey(manager->contacts[manager->table[next]].key) & (spUint)mask);
+
+        /// the entry can move if its home slot is not between the hole and itself
+        if (((next - home) & mask) >= ((next - hole) & mask))
+        {
+            manager->table[hole] = manager->table[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    manager->table[hole] = SP_EMPTY_SLOT;
+
+    /// move the last contact into the removed contacts place to keep the array dense
+    spInt last = --manager->count;
+    if (index != last)
+    {
+        manager->contacts[index] = manager->contacts[last];
+        manager->table[findSlot(manager, manager->contacts[index].key)] = index;
+    }
+}
+
+void
+spPairManagerInit(spPairManager* manager)
+{
+    manager->contacts = NULL;
+    manager->table = NULL;
+    manager->count = 0;
+    manager->capacity = 0;
+    manager->tableSize = 0;
+}
+
+spPairManager
+spPairManagerConstruct()
+{
+    spPairManager manager;
+    spPairManagerInit(&manager);
+    return manager;
+}
+
+void
+spPairManagerDestroy(spPairManager* manager)
+{
+    spFree(&manager->contacts);
+    spFree(&manager->table);
+    spPairManagerInit(manager);
+}
+
+spContact*
+spPairManagerFind(spPairManager* manager, spContactKey key)
+{
+    if (manager->count == 0) return NULL;
+
+    spInt index = manager->table[findSlot(manager, key)];
+    return index == SP_EMPTY_SLOT ? NULL : manager->contacts + index;
+}
+
+spContact*
+spPairManagerAdd(spPairManager* manager, spContactKey key)
+{
+    /// keep the load factor of the table at or below one half
+    if (2 * (manager->count + 1) > manager->tableSize)
+    {
+        growTable(manager);
+    }
+
+    spInt slot = findSlot(manager, key);
+    if (manager->table[slot] != SP_EMPTY_SLOT) return NULL;
+
+    if (manager->count == manager->capacity)
+    {
+        manager->capacity = manager->capacity ? manager->capacity * 2 : 32;
+        manager->contacts = (spContact*) spRealloc(manager->contacts, sizeof(spContact) * manager->capacity);
+        NULLCHECK(manager->contacts);
+    }
+
+    spInt index = manager->count++;
+    spContact* contact = manager->contacts + index;
+    spContactInit(contact, key);
+    manager->table[slot] = index;
+
+    return contact;
+}
+
+void
+spPairManagerRemove(spPairManager* manager, spContactKey key)
+{
+    if (manager->count == 0) return;
+
+    spInt slot = findSlot(manager, key);
+    if (manager->table[slot] == SP_EMPTY_SLOT) return;
+
+    removeSlot(manager, slot);
+}
+
+void
+spPairManagerRemoveAt(spPairManager* manager, spInt index)
+{
+    spAssert(0 <= index && index < manager->count, "contact index is out of range!");
+    removeSlot(manager, findSlot(manager, manager->contacts[index].key));
+}
+
+void
+spPairManagerClear(spPairManager* manager)
+{
+    for (spInt i = 0; i < manager->tableSize; ++i)
+    {
+        manager->table[i] = SP_EMPTY_SLOT;
+    }
+    manager->count = 0;
+}
+
+spContact*
+spPairManagerGetContacts(spPairManager* manager)
+{
+    return manager->contacts;
+}
+
+spInt
+spPairManagerGetCount(spPairManager* manager)
+{
+    return manager->count;
+}
@@ -124,10 +124,13 @@ spPolygonInit(spPolygon* poly, spVector* vertices, spInt count, spFloat mass)
     spMaterial material = { 0.6f, 0.5f };
 
     poly->count = count;
-    poly->edges = (spEdge*) spMalloc(sizeof(spEdge) * count);
+    poly->edges = (spEdge*) spMalloc(sizeof(spEdge) * count * 2);
     poly->radius = 0.2f;
     NULLCHECK(poly->edges);
 
+    /// the world space edges share the allocation
+    poly->worldEdges = poly->edges + count;
+
     /// initialize vertices and normals
     for (spInt i = 0; i < count; ++i)
     {
@@ -137,6 +140,7 @@ spPolygonInit(spPolygon* poly, spVector* vertices, spInt count, spFloat mass)
 
         poly->edges[i].vertex = tail;
         poly->edges[i].normal = normal;
+        poly->worldEdges[i] = poly->edges[i];
     }
 
     spMassData mass_data;
@@ -176,18 +180,46 @@ spPolygonFree(spShape** poly)
     spFree(poly);
 }
 
+spAABB 
+spPolygonComputeAABB(spPolygon* poly)
+{
+    NULLCHECK(poly);
+    spVector min = poly->worldEdges[0].vertex;
+    spVector max = min;
+    for (spInt i = 1; i < poly->count; ++i)
+    {
+        spVector v = poly->worldEdges[i].vertex;
+        min = spVectorConstruct(spMin(min.x, v.x), spMin(min.y, v.y));
+        max = spVectorConstruct(spMax(max.x, v.x), spMax(max.y, v.y));
+    }
+
+    /// add the polygons skin radius
+    spVector radius = spVectorConstruct(poly->radius, poly->radius);
+    return spAABBConstruct(spvSub(min, radius), spvAdd(max, radius));
+}
+
+void 
+spPolygonUpdateWorldEdges(spPolygon* poly, const spTransform* xf)
+{
+    NULLCHECK(poly); NULLCHECK(xf);
+    for (spInt i = 0; i < poly->count; ++i)
+    {
+        poly->worldEdges[i].vertex = spxTransform(*xf, poly->edges[i].vertex);
+        poly->worldEdges[i].normal = sprTransform(xf->q, poly->edges[i].normal);
+    }
+}
+
 spBool 
 spPolygonTestPoint(spPolygon* poly, spVector point)
 {
     NULLCHECK(poly);
-    spTransform* xf = &poly->shape.body->xf;
-    spVector v0 = spxTTransform(*xf, point);
+    spVector v0 = point;
 
     spInt count = poly->count;
     for (spInt i = 0; i < count; ++i)
     {
-        spVector v1 = poly->edges[i].vertex;
-        spVector v2 = poly->edges[(i+1) % count].vertex;
+        spVector v1 = poly->worldEdges[i].vertex;
+        spVector v2 = poly->worldEdges[(i+1) % count].vertex;
 
         spVector A = spvSub(v1, v0);
         spVector B = spvSub(v2, v0);
@@ -1,5 +1,6 @@
 
 #include "spSegment.h"
+#include "spBody.h"
 
 static spVector 
 spSegmentComputeCenterOfMass(const spSegment* segment)
@@ -111,6 +112,19 @@ spSegmentTestPoint(spSegment* segment, const spVector point)
     return spFalse;
 }
 
+spAABB 
+spSegmentComputeAABB(spSegment* segment)
+{
+    NULLCHECK(segment);
+    spTransform* xf = &segment->shape.body->xf;
+    spVector pointA = spxTransform(*xf, segment->pointA);
+    spVector pointB = spxTransform(*xf, segment->pointB);
+    spVector radius = spVectorConstruct(segment->radius, segment->radius);
+    spVector min = spVectorConstruct(spMin(pointA.x, pointB.x), spMin(pointA.y, pointB.y));
+    spVector max = spVectorConstruct(spMax(pointA.x, pointB.x), spMax(pointA.y, pointB.y));
+    return spAABBConstruct(spvSub(min, radius), spvAdd(max, radius));
+}
+
 spVector 
 spSegmentGetPointA(spSegment* segment)
 {
@@ -42,6 +42,8 @@ void spShapeInit(spShape* shape, spMassData* data, spBound* bound, spShapeType t
     shape->body = NULL;
     shape->next = NULL;
     shape->prev = NULL;
+    shape->aabb = spAABBConstruct(spVectorZero(), spVectorZero());
+    shape->proxyId = -1;
     shape->filter = spFilterCollideAll;
 }
 
@@ -98,6 +100,43 @@ spShapeTestPoint(spShape* shape, spVector point)
     return spFalse;
 }
 
+spAABB 
+spShapeComputeAABB(spShape* shape)
+{
+    NULLCHECK(shape);
+    switch (shape->type)
+    {
+    case SP_SHAPE_CIRCLE:
+        return spCircleComputeAABB((spCircle*) shape);
+    case SP_SHAPE_POLYGON:
+        return spPolygonComputeAABB((spPolygon*) shape);
+    case SP_SHAPE_SEGMENT:
+        return spSegmentComputeAABB((spSegment*) shape);
+    default:
+        spAssert(spFalse, "cannot compute the aabb of an unknown shape type!");
+        return spAABBConstruct(spVectorZero(), spVectorZero());
+    }
+}
+
+spFloat
+spShapeGetBoundRadius(const spShape* shape)
+{
+    NULLCHECK(shape);
+    /// polygon bounds only cover the vertices, the other bounds already include the skin
+    if (shape->type == SP_SHAPE_POLYGON)
+    {
+        return shape->bound.radius + ((const spPolygon*) shape)->radius;
+    }
+    return shape->bound.radius;
+}
+
+spFloat
+spShapeGetReach(const spShape* shape)
+{
+    NULLCHECK(shape); NULLCHECK(shape->body);
+    return spDistance(shape->bound.center, shape->body->com) + spShapeGetBoundRadius(shape);
+}
+
 spBool 
 spShapesCanCollide(spShape* a, spShape* b)
 {
@@ -0,0 +1,490 @@
+#include "spSpatialHash.h"
+
+/// context used while finding pairs for a moved proxy
+typedef struct
+{
+    spSpatialHash* grid;  ///< the grid being queried
+    spGridPairFunc func;  ///< pair callback
+    spLazyPointer context; ///< pair callback context
+    spInt queryId;        ///< the moved proxy
+} PairContext;
+
+static INLINE spInt
+cellCoord(spSpatialHash* grid, spFloat value)
+{
+    return (spInt)spfloor(value * grid->invCellSize);
+}
+
+static INLINE spInt
+hashCell(spSpatialHash* grid, spInt x, spInt y)
+{
+    spUint hash = (spUint)x * 73856093u ^ (spUint)y * 19349663u;
+    return (spInt)(hash & (spUint)(grid->bucketCount - 1));
+}
+
+static INLINE spInt
+maxCell(spInt a, spInt b)
+{
+    return a > b ? a : b;
+}
+
+static void
+cellRange(spSpatialHash* grid, const spAABB* aabb, spInt* minX, spInt* minY, spInt* maxX, spInt* maxY)
+{
+    *minX = cellCoord(grid, aabb->min.x);
+    *minY = cellCoord(grid, aabb->min.y);
+    *maxX = cellCoord(grid, aabb->max.x);
+    *maxY = cellCoord(grid, aabb->max.y);
+}
+
+static void
+linkEntry(spSpatialHash* grid, spInt index)
+{
+    spGridEntry* entry = grid->entries + index;
+    spInt bucket = hashCell(grid, entry->x, entry->y);
+    entry->next = grid->buckets[bucket];
+    grid->buckets[bucket] = index;
+}
+
+static void
+growBuckets(spSpatialHash* grid)
+{
+    spInt count = grid->bucketCount ? grid->bucketCount * 2 : 256;
+    spFree(&grid->buckets);
+    grid->buckets = (spInt*) spMalloc(sizeof(spInt) * count);
+    NULLCHECK(grid->buckets);
+    grid->bucketCount = count;
+
+    for (spInt i = 0; i < count; ++i)
+    {
+        grid->buckets[i] = SP_NULL_PROXY;
+    }
+
+    /// relink every entry in use into the new buckets
+    for (spInt i = 0; i < grid->entryCapacity; ++i)
+    {
+        if (grid->entries[i].proxy != SP_NULL_PROXY)
+        {
+            linkEntry(grid, i);
+        }
+    }
+}
+
+static void
+addEntry(spSpatialHash* grid, spInt proxyId, spInt x, spInt y)
+{
+    /// grow the entry pool when the free list runs out
+    if (grid->entryFreeList == SP_NULL_PROXY)
+    {
+        spInt capacity = grid->entryCapacity ? grid->entryCapacity * 2 : 64;
+        grid->entries = (spGridEntry*) spRealloc(grid->entries, sizeof(spGridEntry) * capacity);
+        NULLCHECK(grid->entries);
+        for (spInt i = grid->entryCapacity; i < capacity; ++i)
+        {
+            grid->entries[i].proxy = SP_NULL_PROXY;
+            grid->entries[i].next = i + 1;
+        }
+        grid->entries[capacity-1].next = SP_NULL_PROXY;
+        grid->entryFreeList = grid->entryCapacity;
+        grid->entryCapacity = capacity;
+    }
+
+    /// keep about one entry per bucket so the buckets stay short
+    if (grid->entryCount >= grid->bucketCount)
+    {
+        growBuckets(grid);
+    }
+
+    spInt index = grid->entryFreeList;
+    spGridEntry* entry = grid->entries + index;
+    grid->entryFreeList = entry->next;
+    grid->entryCount++;
+
+    entry->proxy = proxyId;
+    entry->x = x;
+    entry->y = y;
+    linkEntry(grid, index);
+}
+
+static void
+removeEntry(spSpatialHash* grid, spInt proxyId, spInt x, spInt y)
+{
+    spInt* link = grid->buckets + hashCell(grid, x, y);
+    while (*link != SP_NULL_PROXY)
+    {
+        spGridEntry* entry = grid->entries + *link;
+        if (entry->proxy == proxyId && entry->x == x && entry->y == y)
+        {
+            /// unlink the entry and put it in the free list
+            spInt index = *link;
+            *link = entry->next;
+            entry->proxy = SP_NULL_PROXY;
+            entry->next = grid->entryFreeList;
+            grid->entryFreeList = index;
+            grid->entryCount--;
+            return;
+        }
+        link = &entry->next;
+    }
+    spAssert(spFalse, "the proxy is not in the cell!");
+}
+
+static void
+addCells(spSpatialHash* grid, spInt proxyId)
+{
+    spGridProxy* proxy = grid->proxies + proxyId;
+    for (spInt y = proxy->minY; y <= proxy->maxY; ++y)
+    {
+        for (spInt x = proxy->minX; x <= proxy->maxX; ++x)
+        {
+            addEntry(grid, proxyId, x, y);
+        }
+    }
+}
+
+static void
+removeCells(spSpatialHash* grid, spInt proxyId)
+{
+    spGridProxy* proxy = grid->proxies + proxyId;
+    for (spInt y = proxy->minY; y <= proxy->maxY; ++y)
+    {
+        for (spInt x = proxy->minX; x <= proxy->maxX; ++x)
+        {
+            removeEntry(grid, proxyId, x, y);
+        }
+    }
+}
+
+static spInt
+allocateProxy(spSpatialHash* grid)
+{
+    /// grow the proxy pool when the free list runs out
+    if (grid->proxyFreeList == SP_NULL_PROXY)
+    {
+        spInt capacity = grid->proxyCapacity ? grid->proxyCapacity * 2 : 16;
+        grid->proxies = (spGridProxy*) spRealloc(grid->proxies, sizeof(spGridProxy) * capacity);
+        NULLCHECK(grid->proxies);
+        for (spInt i = grid->proxyCapacity; i < capacity; ++i)
+        {
+            /// free proxies have an empty cell range
+            grid->proxies[i].minX = grid->proxies[i].minY = 0;
+            grid->proxies[i].maxX = grid->proxies[i].maxY = -1;
+            grid->proxies[i].next = i + 1;
+        }
+        grid->proxies[capacity-1].next = SP_NULL_PROXY;
+        grid->proxyFreeList = grid->proxyCapacity;
+        grid->proxyCapacity = capacity;
+    }
+
+    spInt index = grid->proxyFreeList;
+    spGridProxy* proxy = grid->proxies + index;
+    grid->proxyFreeList = proxy->next;
+    proxy->next = SP_NULL_PROXY;
+    proxy->data = NULL;
+    proxy->stamp = 0;
+    proxy->moved = spFalse;
+    grid->proxyCount++;
+
+    return index;
+}
+
+static void
+freeProxy(spSpatialHash* grid, spInt proxyId)
+{
+    spGridProxy* proxy = grid->proxies + proxyId;
+    proxy->minX = proxy->minY = 0;
+    proxy->maxX = proxy->maxY = -1;
+    proxy->next = grid->proxyFreeList;
+    grid->proxyFreeList = proxyId;
+    grid->proxyCount--;
+}
+
+static void
+bufferMove(spSpatialHash* grid, spInt proxyId)
+{
+    if (grid->moveCount == grid->moveCapacity)
+    {
+        grid->moveCapacity = grid->moveCapacity ? grid->moveCapacity * 2 : 16;
+        grid->moveBuffer = (spInt*) spRealloc(grid->moveBuffer, sizeof(spInt) * grid->moveCapacity);
+        NULLCHECK(grid->moveBuffer);
+    }
+    grid->moveBuffer[grid->moveCount++] = proxyId;
+    grid->proxies[proxyId].moved = spTrue;
+}
+
+static void
+unbufferMove(spSpatialHash* grid, spInt proxyId)
+{
+    for (spInt i = 0; i < grid->moveCount; ++i)
+    {
+        if (grid->moveBuffer[i] == proxyId)
+        {
+            grid->moveBuffer[i] = SP_NULL_PROXY;
+        }
+    }
+}
+
+static void
+findPairs(spSpatialHash* grid, spInt queryId, spGridPairFunc func, spLazyPointer context)
+{
+    spGridProxy* query = grid->proxies + queryId;
+    for (spInt y = query->minY; y <= query->maxY; ++y)
+    {
+        for (spInt x = query->minX; x <= query->maxX; ++x)
+        {
+            for (spInt i = grid->buckets[hashCell(grid, x, y)]; i != SP_NULL_PROXY; i = grid->entries[i].next)
+            {
+                spGridEntry* entry = grid->entries + i;
+                if (entry->x != x || entry->y != y || entry->proxy == queryId) continue;
+
+                /// both proxies moved, only report the pair once
+                spGridProxy* proxy = grid->proxies + entry->proxy;
+                if (proxy->moved && entry->proxy > queryId) continue;
+
+                /// proxies can share many cells, only report the pair in the
+                /// first cell both proxies are in
+                if (x != maxCell(query->minX, proxy->minX) || y != maxCell(query->minY, proxy->minY)) continue;
+
+                if (spAABBOverlap(&query->aabb, &proxy->aabb))
+                {
+                    func(context, query->data, proxy->data);
+                }
+            }
+        }
+    }
+}
+
+void
+spSpatialHashInit(spSpatialHash* grid, spFloat cellSize)
+{
+    NULLCHECK(grid);
+    spAssert(cellSize > 0.0f, "the cell size must be positive!");
+    grid->proxies = NULL;
+    grid->entries = NULL;
+    grid->buckets = NULL;
+    grid->moveBuffer = NULL;
+    grid->cellSize = cellSize;
+    grid->invCellSize = 1.0f / cellSize;
+    grid->margin = cellSize * SP_GRID_EXTENSION;
+    grid->proxyCount = 0;
+    grid->proxyCapacity = 0;
+    grid->proxyFreeList = SP_NULL_PROXY;
+    grid->entryCount = 0;
+    grid->entryCapacity = 0;
+    grid->entryFreeList = SP_NULL_PROXY;
+    grid->bucketCount = 0;
+    grid->moveCount = 0;
+    grid->moveCapacity = 0;
+    grid->stamp = 0;
+}
+
+spSpatialHash
+spSpatialHashConstruct(spFloat cellSize)
+{
+    spSpatialHash grid;
+    spSpatialHashInit(&grid, cellSize);
+    return grid;
+}
+
+void
+spSpatialHashDestroy(spSpatialHash* grid)
+{
+    NULLCHECK(grid);
+    spFloat cellSize = grid->cellSize;
+    spFloat margin = grid->margin;
+    spFree(&grid->proxies);
+    spFree(&grid->entries);
+    spFree(&grid->buckets);
+    spFree(&grid->moveBuffer);
+    spSpatialHashInit(grid, cellSize);
+    grid->margin = margin;
+}
+
+spInt
+spSpatialHashInsertProxy(spSpatialHash* grid, const spAABB* aabb, spLazyPointer data)
+{
+    NULLCHECK(grid); NULLCHECK(aabb);
+    spInt proxyId = allocateProxy(grid);
+    spGridProxy* proxy = grid->proxies + proxyId;
+
+    /// fatten the aabb so the proxy can move a little without being rehashed
+    proxy->aabb = spAABBFatten(aabb, grid->margin);
+    proxy->data = data;
+    cellRange(grid, &proxy->aabb, &proxy->minX, &proxy->minY, &proxy->maxX, &proxy->maxY);
+
+    addCells(grid, proxyId);
+    bufferMove(grid, proxyId);
+
+    return proxyId;
+}
+
+void
+spSpatialHashRemoveProxy(spSpatialHash* grid, spInt proxyId)
+{
+    NULLCHECK(grid);
+    spAssert(0 <= proxyId && proxyId < grid->proxyCapacity, "proxy id is out of range!");
+
+    if (grid->proxies[proxyId].moved)
+    {
+        unbufferMove(grid, proxyId);
+    }
+    removeCells(grid, proxyId);
+    freeProxy(grid, proxyId);
+}
+
+spBool
+spSpatialHashMoveProxy(spSpatialHash* grid, spInt proxyId, const spAABB* aabb)
+{
+    NULLCHECK(grid); NULLCHECK(aabb);
+    spAssert(0 <= proxyId && proxyId < grid->proxyCapacity, "proxy id is out of range!");
+    spGridProxy* proxy = grid->proxies + proxyId;
+
+    /// the proxy is still inside of its fat box, nothing to do
+    if (spAABBContains(&proxy->aabb, aabb))
+    {
+        return spFalse;
+    }
+
+    proxy->aabb = spAABBFatten(aabb, grid->margin);
+
+    /// only rehash the proxy if the range of cells it touches changed
+    spInt minX, minY, maxX, maxY;
+    cellRange(grid, &proxy->aabb, &minX, &minY, &maxX, &maxY);
+    if (minX != proxy->minX || minY != proxy->minY || maxX != proxy->maxX || maxY != proxy->maxY)
+    {
+        removeCells(grid, proxyId);
+        proxy->minX = minX;
+        proxy->minY = minY;
+        proxy->maxX = maxX;
+        proxy->maxY = maxY;
+        addCells(grid, proxyId);
+    }
+
+    if (proxy->moved == spFalse)
+    {
+        bufferMove(grid, proxyId);
+    }
+    return spTrue;
+}
+
+void
+spSpatialHashQuery(spSpatialHash* grid, const spAABB* aabb, spGridQueryFunc func, spLazyPointer context)
+{
+    NULLCHECK(grid); NULLCHECK(aabb); NULLCHECK(func);
+    if (grid->bucketCount == 0) return;
+
+    /// stamp each proxy as it is visited so proxies in many cells are reported once
+    spInt stamp = ++grid->stamp;
+    spInt minX, minY, maxX, maxY;
+    cellRange(grid, aabb, &minX, &minY, &maxX, &maxY);
+
+    for (spInt y = minY; y <= maxY; ++y)
+    {
+        for (spInt x = minX; x <= maxX; ++x)
+        {
+            for (spInt i = grid->buckets[hashCell(grid, x, y)]; i != SP_NULL_PROXY; i = grid->entries[i].next)
+            {
+                spGridEntry* entry = grid->entries + i;
+                if (entry->x != x || entry->y != y) continue;
+
+                spGridProxy* proxy = grid->proxies + entry->proxy;
+                if (proxy->stamp == stamp) continue;
+                proxy->stamp = stamp;
+
+                if (spAABBOverlap(&proxy->aabb, aabb) && func(context, entry->proxy) == spFalse)
+                {
+                    return;
+                }
+            }
+        }
+    }
+}
+
+void
+spSpatialHashUpdatePairs(spSpatialHash* grid, spGridPairFunc func, spLazyPointer context)
+{
+    NULLCHECK(grid); NULLCHECK(func);
+
+    /// look for pairs in the cells of each proxy that moved
+    for (spInt i = 0; i < grid->moveCount; ++i)
+    {
+        spInt proxyId = grid->moveBuffer[i];
+        if (proxyId == SP_NULL_PROXY) continue;
+
+        findPairs(grid, proxyId, func, context);
+    }
+
+    /// reset the move buffer
+    for (spInt i = 0; i < grid->moveCount; ++i)
+    {
+        spInt proxyId = grid->moveBuffer[i];
+        if (proxyId == SP_NULL_PROXY) continue;
+        grid->proxies[proxyId].moved = spFalse;
+    }
+    grid->moveCount = 0;
+}
+
+spBool
+spSpatialHashTestOverlap(spSpatialHash* grid, spInt proxyA, spInt proxyB)
+{
+    NULLCHECK(grid);
+    spAssert(0 <= proxyA && proxyA < grid->proxyCapacity, "proxy id is out of range!");
+    spAssert(0 <= proxyB && proxyB < grid->proxyCapacity, "proxy id is out of range!");
+    return spAABBOverlap(&grid->proxies[proxyA].aabb, &grid->proxies[proxyB].aabb);
+}
+
+spAABB
+spSpatialHashGetFatAABB(spSpatialHash* grid, spInt proxyId)
+{
+    NULLCHECK(grid);
+    spAssert(0 <= proxyId && proxyId < grid->proxyCapacity, "proxy id is out of range!");
+    return grid->proxies[proxyId].aabb;
+}
+
+spLazyPointer
+spSpatialHashGetData(spSpatialHash* grid, spInt proxyId)
+{
+    NULLCHECK(grid);
+    spAssert(0 <= proxyId && proxyId < grid->proxyCapacity, "proxy id is out of range!");
+    return grid->proxies[proxyId].data;
+}
+
+spFloat
+spSpatialHashGetCellSize(spSpatialHash* grid)
+{
+    NULLCHECK(grid);
+    return grid->cellSize;
+}
+
+void
+spSpatialHashSetCellSize(spSpatialHash* grid, spFloat cellSize)
+{
+    NULLCHECK(grid);
+    spAssert(cellSize > 0.0f, "the cell size must be positive!");
+
+    /// free proxies have an empty cell range, so they are skipped by the loops
+    for (spInt i = 0; i < grid->proxyCapacity; ++i)
+    {
+        removeCells(grid, i);
+    }
+
+    grid->cellSize = cellSize;
+    grid->invCellSize = 1.0f / cellSize;
+
+    for (spInt i = 0; i < grid->proxyCapacity; ++i)
+    {
+        spGridProxy* proxy = grid->proxies + i;
+        if (proxy->minX > proxy->maxX) continue;
+
+        cellRange(grid, &proxy->aabb, &proxy->minX, &proxy->minY, &proxy->maxX, &proxy->maxY);
+        addCells(grid, i);
+    }
+}
+
+void
+spSpatialHashSetMargin(spSpatialHash* grid, spFloat margin)
+{
+    NULLCHECK(grid);
+    spAssert(margin >= 0.0f, "the margin cannot be negative!");
+    grid->margin = margin;
+}
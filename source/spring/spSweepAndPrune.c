@@ -1,194 +1,672 @@
-
-#include "spSweepAndPrune.h"
-#include "spBound.h"
-#include "spShape.h"
-#include "spBody.h"
-
-spAxis g_axis = SP_X;
-
-static int 
-CompareIntervals(const void* a, const void* b)
-{
-    spSapBox** BoxA = (spSapBox**)a;
-    spSapBox** BoxB = (spSapBox**)b;
-    spSapBox* boxA = *BoxA;
-    spSapBox* boxB = *BoxB;
-
-    float minA = boxA->axis[g_axis].min;
-    float minB = boxB->axis[g_axis].min;
-
-    if (minA >= minB)
-    {
-        return 1;
-    }
-    else if (minA < minB)
-    {
-        return -1;
-    }
-    return 0;
-}
-
-static spSapBox*
-BoxNew(spShape* shape)
-{
-    spSapBox* box = (spSapBox*) spMalloc(sizeof(spSapBox));
-
-    spInterval zero;
-    zero.min = 0.0f;
-    zero.max = 0.0f;
-
-    box->shape = shape;
-    box->axis[0] = zero;
-    box->axis[1] = zero;
-
-    return box;
-}
-
-static void
-BoxFree(spSapBox* box)
-{
-    NULLCHECK(box);
-    free(box);
-}
-
-static void
-UpdateBox(spSapBox* box)
-{
-    spShape* shape = box->shape;
-    spBound* bound = &shape->bound;
-    spVector center = spBoundGetWorldCenter(bound, &shape->body->xf);
-    spVector width = spBoundGetHalfWidth(bound);
-
-    box->axis[SP_X].min = center.x - width.x;
-    box->axis[SP_X].max = center.x + width.x;
-    box->axis[SP_Y].min = center.y - width.y;
-    box->axis[SP_Y].max = center.y + width.y;
-}
-
-spSap 
-spSapConstruct()
-{
-    spSap sap;
-    spMemset(sap.boxes, 0, sizeof(spSapBox**)*SP_MAX_SAP_OBJECTS);
-    sap.count = 0;
-
-    return sap;
-}
-
-void 
-spSapDestroy(spSap* sap)
-{
-    for (spInt i = sap->count-1; i >= 0; --i)
-    {
-        BoxFree(sap->boxes[i]);
-    }
-    sap->count = 0;
-}
-
-void 
-spSapInsert(spSap* sap, spShape* shape)
-{
-    spSapBox* box = BoxNew(shape);
-    sap->boxes[sap->count++] = box;
-}
-
-void 
-spSapRemove(spSap* sap, spShape* shape)
-{
-    spInt index = -1;
-    for (spInt i = 0; i < sap->count; ++i)
-    {
-        if (sap->boxes[i]->shape == shape)
-        {
-            index = i;
-            break;
-        }
-    }
-
-    spAssert(index >= -1, "Error: cannot remove an object that isnt in the sap list!");
-
-    BoxFree(sap->boxes[index]);
-
-    sap->count--;
-    sap->boxes[index] = sap->boxes[sap->count];
-    sap->boxes[sap->count] = NULL;
-}
-
-void 
-spSapUpdate(spSap* sap)
-{
-    spSapUpdateSortAxis(sap);
-
-    for (spInt i = 0; i < sap->count; ++i)
-    {
-        UpdateBox(sap->boxes[i]);
-    }
-}
-
-void 
-spSapSort(spSap* sap)
-{
-    qsort(sap->boxes, sap->count, sizeof(spSapBox*), CompareIntervals);
-}
-
-spVariance 
-spSapVariance(spSap* sap)
-{
-    spVariance s, s2, variance;
-    spSapBox** boxes = sap->boxes;
-
-    for (spInt i = 0; i < sap->count; ++i)
-    {
-        for (spInt j = 0; j < 2; ++j)
-        {
-            spInterval* interval = &boxes[i]->axis[j];
-            spFloat center = 0.5f * (interval->min + interval->max);
-
-            s.axis[j]  += center;
-            s2.axis[j] += center * center;
-        }
-    }
-
-    spFloat invObjects = 1 / (spFloat)sap->count;
-    for (spInt i = 0; i < 2; ++i)
-    {
-        variance.axis[i] = s2.axis[i] - s.axis[i] * s.axis[i] * invObjects;
-    }
-
-    return variance;
-}
-
-void 
-spSapUpdateSortAxis(spSap* sap)
-{
-    spVariance variance = spSapVariance(sap);
-
-    g_axis = SP_X;
-    if (variance.axis[SP_Y] >= variance.axis[SP_X])
-    {
-        g_axis = SP_Y;
-    }
-}
-
-spBool 
-spIntervalsDontOverlap(spSapBox** boxes, spInt i, spInt j)
-{
-    if (boxes[j]->axis[g_axis].min > boxes[i]->axis[g_axis].max)
-    {
-        return spTrue;
-    }
-    return spFalse;
-}
-
-spBool 
-spBoxesOverlap(spSapBox* a, spSapBox* b)
-{
-    /// check if the two intervals overlap at all
-    if (a->axis[SP_X].max < b->axis[SP_X].min) return spFalse;
-    if (a->axis[SP_X].min > b->axis[SP_X].max) return spFalse;
-    if (a->axis[SP_Y].max < b->axis[SP_Y].min) return spFalse;
-    if (a->axis[SP_Y].min > b->axis[SP_Y].max) return spFalse;
-
-    /// they do overlap, return true
-    return spTrue;
-}
\ No newline at end of file
+#include "spSweepAndPrune.h"
+
+#ifdef SP_SSE2
+#include <emmintrin.h>
+#endif
+
+/// endpoint data packing helpers
+#define ENDPOINT_DATA(box, isMax) (((box) << 1) | (isMax))
+#define ENDPOINT_BOX(endpoint) ((endpoint).data >> 1)
+#define ENDPOINT_IS_MAX(endpoint) ((endpoint).data & 1)
+
+/// endpoints are radix sorted in batches larger than this, smaller batches use an insertion sort
+#define SP_SAP_RADIX_THRESHOLD 64
+
+/// boxes that are open during a sweep, stored as arrays so several boxes can be tested at once
+typedef struct
+{
+    spInt* box;   ///< box index
+    spFloat* min; ///< min of the box along the other axis
+    spFloat* max; ///< max of the box along the other axis
+    spInt count;  ///< number of open boxes
+} OpenList;
+
+static INLINE spUint
+RadixKey(spFloat value)
+{
+    /// flip the float bits so they sort as unsigned integers. negative floats have every
+    /// bit flipped, positive floats only have the sign bit flipped
+    union { spFloat f; spUint u; } bits;
+    bits.f = value;
+    return bits.u ^ ((spUint)(-(spInt)(bits.u >> 31)) | 0x80000000u);
+}
+
+static void
+InsertionSortEndpoints(spSapEndpoint* endpoints, spInt count)
+{
+    for (spInt i = 1; i < count; ++i)
+    {
+        spSapEndpoint endpoint = endpoints[i];
+        spInt j = i - 1;
+        while (j >= 0 && endpoints[j].value > endpoint.value)
+        {
+            endpoints[j+1] = endpoints[j];
+            --j;
+        }
+        endpoints[j+1] = endpoint;
+    }
+}
+
+static void
+RadixSortEndpoints(spSapEndpoint* endpoints, spSapEndpoint* scratch, spInt count)
+{
+    if (count < SP_SAP_RADIX_THRESHOLD)
+    {
+        InsertionSortEndpoints(endpoints, count);
+        return;
+    }
+
+    /// lsd radix sort, one byte per pass. an even number of passes leaves the result in endpoints
+    spSapEndpoint* src = endpoints;
+    spSapEndpoint* dst = scratch;
+    for (spUint shift = 0; shift < 32; shift += 8)
+    {
+        spInt offsets[256] = { 0 };
+        for (spInt i = 0; i < count; ++i)
+        {
+            offsets[(RadixKey(src[i].value) >> shift) & 0xFF]++;
+        }
+
+        spInt sum = 0;
+        for (spInt i = 0; i < 256; ++i)
+        {
+            spInt bucket = offsets[i];
+            offsets[i] = sum;
+            sum += bucket;
+        }
+
+        for (spInt i = 0; i < count; ++i)
+        {
+            dst[offsets[(RadixKey(src[i].value) >> shift) & 0xFF]++] = src[i];
+        }
+
+        spSapEndpoint* swap = src;
+        src = dst;
+        dst = swap;
+    }
+}
+
+static void
+OpenListPush(OpenList* list, spInt* slots, spInt index, const spInterval* interval)
+{
+    spInt slot = list->count++;
+    list->box[slot] = index;
+    list->min[slot] = interval->min;
+    list->max[slot] = interval->max;
+    slots[index] = slot;
+}
+
+static void
+OpenListRemove(OpenList* list, spInt* slots, spInt index)
+{
+    /// move the last open box into the removed boxes slot
+    spInt slot = slots[index];
+    spInt last = --list->count;
+    list->box[slot] = list->box[last];
+    list->min[slot] = list->min[last];
+    list->max[slot] = list->max[last];
+    slots[list->box[slot]] = slot;
+}
+
+static void
+OpenListFindPairs(OpenList* list, spSap* sap, spInt index, spInt axis, spSapPairFunc addPair, spLazyPointer context)
+{
+    spSapBox* box = sap->boxes + index;
+    spFloat min = box->axis[axis].min;
+    spFloat max = box->axis[axis].max;
+    spInt i = 0;
+
+#ifdef SP_SSE2
+    /// test four open boxes at a time
+    __m128 boxMin = _mm_set1_ps(min);
+    __m128 boxMax = _mm_set1_ps(max);
+    for (; i + 4 <= list->count; i += 4)
+    {
+        __m128 openMin = _mm_loadu_ps(list->min + i);
+        __m128 openMax = _mm_loadu_ps(list->max + i);
+        __m128 overlap = _mm_and_ps(_mm_cmpge_ps(openMax, boxMin), _mm_cmple_ps(openMin, boxMax));
+        spInt mask = _mm_movemask_ps(overlap);
+        for (spInt j = 0; mask != 0; ++j, mask >>= 1)
+        {
+            if (mask & 1)
+            {
+                addPair(context, box->shape, sap->boxes[list->box[i+j]].shape);
+            }
+        }
+    }
+#endif
+
+    for (; i < list->count; ++i)
+    {
+        if (list->max[i] >= min && list->min[i] <= max)
+        {
+            addPair(context, box->shape, sap->boxes[list->box[i]].shape);
+        }
+    }
+}
+
+static void
+SetBox(spSapBox* box, const spAABB* aabb)
+{
+    box->axis[SP_X].min = aabb->min.x;
+    box->axis[SP_X].max = aabb->max.x;
+    box->axis[SP_Y].min = aabb->min.y;
+    box->axis[SP_Y].max = aabb->max.y;
+}
+
+static void
+GrowEndpoints(spSap* sap, spInt count)
+{
+    if (count <= sap->endpointCapacity) return;
+
+    while (sap->endpointCapacity < count)
+    {
+        sap->endpointCapacity = sap->endpointCapacity ? sap->endpointCapacity * 2 : 64;
+    }
+    for (spInt axis = 0; axis < 2; ++axis)
+    {
+        sap->endpoints[axis] = (spSapEndpoint*) spRealloc(sap->endpoints[axis], sizeof(spSapEndpoint) * sap->endpointCapacity);
+        NULLCHECK(sap->endpoints[axis]);
+    }
+}
+
+static void
+RemoveEndpoints(spSap* sap)
+{
+    /// compact the endpoint lists, dropping the endpoints of removed boxes. both axes hold the
+    /// same boxes, so the count is only stored once both are compacted
+    spInt count = 0;
+    for (spInt axis = 0; axis < 2; ++axis)
+    {
+        spSapEndpoint* endpoints = sap->endpoints[axis];
+        count = 0;
+        for (spInt i = 0; i < sap->endpointCount; ++i)
+        {
+            spInt index = ENDPOINT_BOX(endpoints[i]);
+            if (sap->boxes[index].shape != NULL)
+            {
+                endpoints[count++] = endpoints[i];
+            }
+
+            /// put the removed box back in the free list once
+            else if (axis == SP_X && ENDPOINT_IS_MAX(endpoints[i]) == spFalse)
+            {
+                sap->boxes[index].next = sap->freeList;
+                sap->freeList = index;
+            }
+        }
+    }
+    sap->endpointCount = count;
+    sap->removedCount = 0;
+}
+
+static void
+SortAxis(spSap* sap, spInt axis, spSapPairFunc addPair, spSapPairFunc removePair, spLazyPointer context)
+{
+    spSapEndpoint* endpoints = sap->endpoints[axis];
+    spSapBox* boxes = sap->boxes;
+
+    /// insertion sort, the list is nearly sorted from the last step
+    for (spInt i = 1; i < sap->endpointCount; ++i)
+    {
+        spSapEndpoint endpoint = endpoints[i];
+        spSapBox* box = boxes + ENDPOINT_BOX(endpoint);
+        spInt j = i - 1;
+
+        while (j >= 0 && endpoints[j].value > endpoint.value)
+        {
+            spSapEndpoint swapped = endpoints[j];
+            spSapBox* swappedBox = boxes + ENDPOINT_BOX(swapped);
+
+            /// a min moved below a max, the boxes may have started overlapping
+            if (ENDPOINT_IS_MAX(endpoint) == spFalse && ENDPOINT_IS_MAX(swapped))
+            {
+                if (spBoxesOverlap(box, swappedBox))
+                {
+                    addPair(context, box->shape, swappedBox->shape);
+                }
+            }
+
+            /// a max moved below a min, the boxes stopped overlapping
+            else if (ENDPOINT_IS_MAX(endpoint) && ENDPOINT_IS_MAX(swapped) == spFalse)
+            {
+                removePair(context, box->shape, swappedBox->shape);
+            }
+
+            endpoints[j+1] = swapped;
+            --j;
+        }
+        endpoints[j+1] = endpoint;
+    }
+}
+
+static void
+InsertPending(spSap* sap, spSapPairFunc addPair, spLazyPointer context)
+{
+    spInt oldCount = sap->endpointCount;
+    spInt newCount = sap->pendingCount * 2;
+    spInt total = oldCount + newCount;
+    GrowEndpoints(sap, total);
+
+    /// the new endpoints and the radix sort scratch after them
+    if (sap->freshCapacity < newCount * 2)
+    {
+        while (sap->freshCapacity < newCount * 2)
+        {
+            sap->freshCapacity = sap->freshCapacity ? sap->freshCapacity * 2 : 64;
+        }
+        sap->fresh = (spSapEndpoint*) spRealloc(sap->fresh, sizeof(spSapEndpoint) * sap->freshCapacity);
+        NULLCHECK(sap->fresh);
+    }
+    spSapEndpoint* fresh = sap->fresh;
+    spBool* isNew = sap->isNew;
+
+    for (spInt i = 0; i < sap->pendingCount; ++i)
+    {
+        isNew[sap->pending[i]] = spTrue;
+    }
+
+    for (spInt axis = 0; axis < 2; ++axis)
+    {
+        /// sort the new endpoints among themselves
+        for (spInt i = 0; i < sap->pendingCount; ++i)
+        {
+            spInt index = sap->pending[i];
+            spInterval* interval = &sap->boxes[index].axis[axis];
+            sap->extent[axis] = spMax(sap->extent[axis], interval->max - interval->min);
+            fresh[i*2+0].value = sap->boxes[index].axis[axis].min;
+            fresh[i*2+0].data  = ENDPOINT_DATA(index, 0);
+            fresh[i*2+1].value = sap->boxes[index].axis[axis].max;
+            fresh[i*2+1].data  = ENDPOINT_DATA(index, 1);
+        }
+        RadixSortEndpoints(fresh, fresh + newCount, newCount);
+
+        /// merge them into the sorted list from the back
+        spSapEndpoint* endpoints = sap->endpoints[axis];
+        spInt i = oldCount - 1;
+        spInt j = newCount - 1;
+        for (spInt k = total - 1; j >= 0; --k)
+        {
+            if (i >= 0 && endpoints[i].value > fresh[j].value)
+            {
+                endpoints[k] = endpoints[i--];
+            }
+            else
+            {
+                endpoints[k] = fresh[j--];
+            }
+        }
+    }
+    sap->endpointCount = total;
+
+    /// sweep along the axis with the most spread to find every pair with a new box. new and old
+    /// boxes are kept in separate open lists, so old boxes are never tested against each other
+    spSapUpdateSortAxis(sap);
+    spSapEndpoint* endpoints = sap->endpoints[sap->axis];
+    spInt other = sap->axis ^ 1;
+
+    spInt count = sap->count;
+    if (sap->slotCapacity < sap->boxCapacity + 2 * count)
+    {
+        while (sap->slotCapacity < sap->boxCapacity + 2 * count)
+        {
+            sap->slotCapacity = sap->slotCapacity ? sap->slotCapacity * 2 : 64;
+        }
+        sap->slots = (spInt*) spRealloc(sap->slots, sizeof(spInt) * sap->slotCapacity);
+        NULLCHECK(sap->slots);
+    }
+    if (sap->boundCapacity < 4 * count)
+    {
+        while (sap->boundCapacity < 4 * count)
+        {
+            sap->boundCapacity = sap->boundCapacity ? sap->boundCapacity * 2 : 64;
+        }
+        sap->bounds = (spFloat*) spRealloc(sap->bounds, sizeof(spFloat) * sap->boundCapacity);
+        NULLCHECK(sap->bounds);
+    }
+    spInt* slots = sap->slots;
+    spFloat* bounds = sap->bounds;
+    OpenList openNew = { slots + sap->boxCapacity,         bounds,             bounds + count,     0 };
+    OpenList openOld = { slots + sap->boxCapacity + count, bounds + 2 * count, bounds + 3 * count, 0 };
+
+    for (spInt i = 0; i < total; ++i)
+    {
+        spInt index = ENDPOINT_BOX(endpoints[i]);
+        OpenList* list = isNew[index] ? &openNew : &openOld;
+
+        /// the box closed, remove it from the open list
+        if (ENDPOINT_IS_MAX(endpoints[i]))
+        {
+            OpenListRemove(list, slots, index);
+            continue;
+        }
+
+        /// the box opened, test it against the open boxes that could make a new pair
+        OpenListFindPairs(&openNew, sap, index, other, addPair, context);
+        if (isNew[index])
+        {
+            OpenListFindPairs(&openOld, sap, index, other, addPair, context);
+        }
+        OpenListPush(list, slots, index, &sap->boxes[index].axis[other]);
+    }
+
+    /// only the pending boxes were marked, so only they are cleared
+    for (spInt i = 0; i < sap->pendingCount; ++i)
+    {
+        isNew[sap->pending[i]] = spFalse;
+        sap->boxes[sap->pending[i]].stale = spFalse;
+    }
+    sap->pendingCount = 0;
+}
+
+spSap
+spSapConstruct()
+{
+    spSap sap;
+    sap.boxes = NULL;
+    sap.endpoints[SP_X] = NULL;
+    sap.endpoints[SP_Y] = NULL;
+    sap.pending = NULL;
+    sap.moved = NULL;
+    sap.fresh = NULL;
+    sap.isNew = NULL;
+    sap.slots = NULL;
+    sap.bounds = NULL;
+    sap.boxCapacity = 0;
+    sap.freeList = -1;
+    sap.endpointCount = 0;
+    sap.endpointCapacity = 0;
+    sap.pendingCount = 0;
+    sap.pendingCapacity = 0;
+    sap.movedCount = 0;
+    sap.movedCapacity = 0;
+    sap.freshCapacity = 0;
+    sap.slotCapacity = 0;
+    sap.boundCapacity = 0;
+    sap.removedCount = 0;
+    sap.count = 0;
+    sap.extent[SP_X] = 0.0f;
+    sap.extent[SP_Y] = 0.0f;
+    sap.variance.axis[SP_X] = 0.0f;
+    sap.variance.axis[SP_Y] = 0.0f;
+    sap.axis = SP_X;
+
+    return sap;
+}
+
+void
+spSapDestroy(spSap* sap)
+{
+    spFree(&sap->boxes);
+    spFree(&sap->endpoints[SP_X]);
+    spFree(&sap->endpoints[SP_Y]);
+    spFree(&sap->pending);
+    spFree(&sap->moved);
+    spFree(&sap->fresh);
+    spFree(&sap->isNew);
+    spFree(&sap->slots);
+    spFree(&sap->bounds);
+    *sap = spSapConstruct();
+}
+
+spInt
+spSapInsert(spSap* sap, spShape* shape, const spAABB* aabb)
+{
+    /// grow the box pool and link the new boxes into the free list
+    if (sap->freeList == -1)
+    {
+        spInt capacity = sap->boxCapacity ? sap->boxCapacity * 2 : 64;
+        sap->boxes = (spSapBox*) spRealloc(sap->boxes, sizeof(spSapBox) * capacity);
+        sap->isNew = (spBool*) spRealloc(sap->isNew, sizeof(spBool) * capacity);
+        NULLCHECK(sap->boxes); NULLCHECK(sap->isNew);
+        for (spInt i = sap->boxCapacity; i < capacity; ++i)
+        {
+            sap->boxes[i].shape = NULL;
+            sap->boxes[i].next = i + 1;
+            sap->isNew[i] = spFalse;
+        }
+        sap->boxes[capacity-1].next = -1;
+        sap->freeList = sap->boxCapacity;
+        sap->boxCapacity = capacity;
+    }
+
+    /// pop a box off of the free list
+    spInt index = sap->freeList;
+    spSapBox* box = sap->boxes + index;
+    sap->freeList = box->next;
+    box->shape = shape;
+    box->next = -1;
+    box->stale = spTrue;
+    SetBox(box, aabb);
+    sap->count++;
+
+    /// the box is added to the endpoint lists during the next update
+    if (sap->pendingCount == sap->pendingCapacity)
+    {
+        sap->pendingCapacity = sap->pendingCapacity ? sap->pendingCapacity * 2 : 16;
+        sap->pending = (spInt*) spRealloc(sap->pending, sizeof(spInt) * sap->pendingCapacity);
+        NULLCHECK(sap->pending);
+    }
+    sap->pending[sap->pendingCount++] = index;
+
+    return index;
+}
+
+void
+spSapRemove(spSap* sap, spInt index)
+{
+    spAssert(0 <= index && index < sap->boxCapacity, "Error: cannot remove an object that isnt in the sap list!");
+    spAssert(sap->boxes[index].shape != NULL, "Error: cannot remove an object that isnt in the sap list!");
+
+    sap->boxes[index].shape = NULL;
+    sap->count--;
+
+    /// the box never made it into the endpoint lists, free it right away
+    for (spInt i = 0; i < sap->pendingCount; ++i)
+    {
+        if (sap->pending[i] == index)
+        {
+            sap->pending[i] = sap->pending[--sap->pendingCount];
+            sap->boxes[index].next = sap->freeList;
+            sap->freeList = index;
+            return;
+        }
+    }
+
+    /// its endpoints are removed during the next update
+    sap->removedCount++;
+}
+
+void
+spSapUpdate(spSap* sap, spSapPairFunc addPair, spSapPairFunc removePair, spLazyPointer context)
+{
+    /// drop the endpoints of removed boxes
+    if (sap->removedCount > 0)
+    {
+        RemoveEndpoints(sap);
+    }
+
+    /// copy the new intervals into the endpoints and re-sort each axis
+    for (spInt axis = 0; axis < 2; ++axis)
+    {
+        spSapEndpoint* endpoints = sap->endpoints[axis];
+        spFloat extent = 0.0f;
+        for (spInt i = 0; i < sap->endpointCount; ++i)
+        {
+            spInterval* interval = &sap->boxes[ENDPOINT_BOX(endpoints[i])].axis[axis];
+            endpoints[i].value = ENDPOINT_IS_MAX(endpoints[i]) ? interval->max : interval->min;
+            extent = spMax(extent, interval->max - interval->min);
+        }
+        sap->extent[axis] = extent;
+        SortAxis(sap, axis, addPair, removePair, context);
+    }
+
+    /// the endpoints of the moved boxes are up to date again
+    for (spInt i = 0; i < sap->movedCount; ++i)
+    {
+        sap->boxes[sap->moved[i]].stale = spFalse;
+    }
+    sap->movedCount = 0;
+
+    /// merge in the boxes that were inserted since the last update
+    if (sap->pendingCount > 0)
+    {
+        InsertPending(sap, addPair, context);
+    }
+}
+
+void
+spSapMove(spSap* sap, spInt box, const spAABB* aabb)
+{
+    spAssert(0 <= box && box < sap->boxCapacity, "box index is out of range!");
+    SetBox(sap->boxes + box, aabb);
+
+    /// queries test the box on its own until the next update re-sorts its endpoints
+    if (sap->boxes[box].stale) return;
+    sap->boxes[box].stale = spTrue;
+    if (sap->movedCount == sap->movedCapacity)
+    {
+        sap->movedCapacity = sap->movedCapacity ? sap->movedCapacity * 2 : 16;
+        sap->moved = (spInt*) spRealloc(sap->moved, sizeof(spInt) * sap->movedCapacity);
+        NULLCHECK(sap->moved);
+    }
+    sap->moved[sap->movedCount++] = box;
+}
+
+void
+spSapQuery(spSap* sap, const spAABB* aabb, spSapQueryFunc func, spLazyPointer context)
+{
+    spSapBox query;
+    SetBox(&query, aabb);
+
+    /// a box overlapping the query along the sweep axis has its min endpoint no further back than the
+    /// widest box, so binary search for the first endpoint that can belong to one
+    spInt axis = sap->axis;
+    spSapEndpoint* endpoints = sap->endpoints[axis];
+    spFloat min = query.axis[axis].min - sap->extent[axis];
+    spFloat max = query.axis[axis].max;
+    spInt lo = 0;
+    spInt hi = sap->endpointCount;
+    while (lo < hi)
+    {
+        spInt mid = (lo + hi) >> 1;
+        if (endpoints[mid].value < min)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    /// test the boxes that open before the query closes, removed and stale boxes are skipped
+    for (spInt i = lo; i < sap->endpointCount && endpoints[i].value <= max; ++i)
+    {
+        if (ENDPOINT_IS_MAX(endpoints[i])) continue;
+
+        spInt index = ENDPOINT_BOX(endpoints[i]);
+        spSapBox* box = sap->boxes + index;
+        if (box->shape == NULL || box->stale) continue;
+
+        if (spBoxesOverlap(box, &query) && func(context, index) == spFalse)
+        {
+            return;
+        }
+    }
+
+    /// pending and moved boxes are not where their endpoints say, test them one by one
+    for (spInt i = 0; i < sap->pendingCount; ++i)
+    {
+        spInt index = sap->pending[i];
+        if (spBoxesOverlap(sap->boxes + index, &query) && func(context, index) == spFalse)
+        {
+            return;
+        }
+    }
+    for (spInt i = 0; i < sap->movedCount; ++i)
+    {
+        spInt index = sap->moved[i];
+        if (sap->boxes[index].shape == NULL) continue;
+
+        if (spBoxesOverlap(sap->boxes + index, &query) && func(context, index) == spFalse)
+        {
+            return;
+        }
+    }
+}
+
+spVariance
+spSapVariance(spSap* sap)
+{
+    spVariance s, s2, variance;
+    spSapBox* boxes = sap->boxes;
+
+    for (spInt i = 0; i < 2; ++i)
+    {
+        s.axis[i] = 0.0f;
+        s2.axis[i] = 0.0f;
+        variance.axis[i] = 0.0f;
+    }
+
+    if (sap->count == 0)
+    {
+        return variance;
+    }
+
+    for (spInt i = 0; i < sap->boxCapacity; ++i)
+    {
+        if (boxes[i].shape == NULL) continue;
+
+        for (spInt j = 0; j < 2; ++j)
+        {
+            spInterval* interval = &boxes[i].axis[j];
+            spFloat center = 0.5f * (interval->min + interval->max);
+
+            s.axis[j]  += center;
+            s2.axis[j] += center * center;
+        }
+    }
+
+    spFloat invObjects = 1 / (spFloat)sap->count;
+    for (spInt i = 0; i < 2; ++i)
+    {
+        variance.axis[i] = s2.axis[i] - s.axis[i] * s.axis[i] * invObjects;
+    }
+
+    return variance;
+}
+
+void
+spSapUpdateSortAxis(spSap* sap)
+{
+    spVariance variance = spSapVariance(sap);
+    sap->variance = variance;
+
+    sap->axis = SP_X;
+    if (variance.axis[SP_Y] >= variance.axis[SP_X])
+    {
+        sap->axis = SP_Y;
+    }
+}
+
+spBool
+spSapTestOverlap(spSap* sap, spInt boxA, spInt boxB)
+{
+    spAssert(0 <= boxA && boxA < sap->boxCapacity, "box index is out of range!");
+    spAssert(0 <= boxB && boxB < sap->boxCapacity, "box index is out of range!");
+    return spBoxesOverlap(sap->boxes + boxA, sap->boxes + boxB);
+}
+
+spBool
+spBoxesOverlap(spSapBox* a, spSapBox* b)
+{
+    /// check if the two intervals overlap at all
+    if (a->axis[SP_X].max < b->axis[SP_X].min) return spFalse;
+    if (a->axis[SP_X].min > b->axis[SP_X].max) return spFalse;
+    if (a->axis[SP_Y].max < b->axis[SP_Y].min) return spFalse;
+    if (a->axis[SP_Y].min > b->axis[SP_Y].max) return spFalse;
+
+    /// they do overlap, return true
+    return spTrue;
+}
@@ -0,0 +1,375 @@
+
+#include "spThreadPool.h"
+
+#include <stdlib.h>
+
+#if !defined(_WIN32)
+  #include <unistd.h>
+#endif
+
+/// thin wrappers over the os threading primitives
+
+#if defined(_WIN32)
+  #define spMutexInit(m)          InitializeCriticalSection(m)
+  #define spMutexDestroy(m)       DeleteCriticalSection(m)
+  #define spMutexLock(m)          EnterCriticalSection(m)
+  #define spMutexUnlock(m)        LeaveCriticalSection(m)
+  #define spConditionInit(c)      InitializeConditionVariable(c)
+  #define spConditionDestroy(c)
+  #define spConditionWait(c, m)   SleepConditionVariableCS(c, m, INFINITE)
+  #define spConditionBroadcast(c) WakeAllConditionVariable(c)
+  #define spConditionSignal(c)    WakeConditionVariable(c)
+#else
+  #define spMutexInit(m)          pthread_mutex_init(m, NULL)
+  #define spMutexDestroy(m)       pthread_mutex_destroy(m)
+  #define spMutexLock(m)          pthread_mutex_lock(m)
+  #define spMutexUnlock(m)        pthread_mutex_unlock(m)
+  #define spConditionInit(c)      pthread_cond_init(c, NULL)
+  #define spConditionDestroy(c)   pthread_cond_destroy(c)
+  #define spConditionWait(c, m)   pthread_cond_wait(c, m)
+  #define spConditionBroadcast(c) pthread_cond_broadcast(c)
+  #define spConditionSignal(c)    pthread_cond_signal(c)
+#endif
+
+static void
+runRange(spThreadPool* pool, spInt range)
+{
+    /// ranges are split evenly, the first and last item only depend on the item and range count
+    spInt begin = (spInt)((long long)pool->count * range / pool->ranges);
+    spInt end   = (spInt)((long long)pool->count * (range + 1) / pool->ranges);
+    if (begin < end)
+    {
+        pool->func(pool->context, begin, end, range);
+    }
+}
+
+static int
+compareTaskCost(const void* a, const void* b)
+{
+    /// (cost, task) pairs, biggest cost first, then lowest task so the order never depends on qsort
+    const spInt* taskA = (const spInt*) a;
+    const spInt* taskB = (const spInt*) b;
+    if (taskA[0] != taskB[0]) return taskA[0] > taskB[0] ? -1 : 1;
+    return taskA[1] < taskB[1] ? -1 : taskA[1] > taskB[1];
+}
+
+static spInt
+popTask(spTaskDeque* deque)
+{
+    spInt task = -1;
+    spMutexLock(&deque->mutex);
+    if (deque->front < deque->back)
+    {
+        task = deque->front++;
+    }
+    spMutexUnlock(&deque->mutex);
+    return task;
+}
+
+static spInt
+stealTask(spTaskDeque* deque)
+{
+    spInt task = -1;
+    spMutexLock(&deque->mutex);
+    if (deque->front < deque->back)
+    {
+        task = --deque->back;
+    }
+    spMutexUnlock(&deque->mutex);
+    return task;
+}
+
+static void
+runTasks(spThreadPool* pool, spInt begin, spInt end, spInt thread)
+{
+    spInt threads = pool->threadCount;
+    for (;;)
+    {
+        /// run this threads own tasks first, then steal from the others in a fixed order
+        spInt task = popTask(pool->deques + thread);
+        for (spInt i = 1; task == -1 && i < threads; ++i)
+        {
+            task = stealTask(pool->deques + (thread + i) % threads);
+        }
+
+        /// no task is ever added during a job, so once every deque is empty the job is done
+        if (task == -1) return;
+        pool->taskFunc(pool->taskContext, pool->tasks[task], thread);
+    }
+}
+
+static void
+workerLoop(spThreadPoolWorker* worker)
+{
+    spThreadPool* pool = worker->pool;
+    spInt generation = 0;
+
+    spMutexLock(&pool->mutex);
+    for (;;)
+    {
+        /// wait for a new job or for the pool to shut down
+        while (pool->quit == spFalse && pool->generation == generation)
+        {
+            spConditionWait(&pool->wake, &pool->mutex);
+        }
+        if (pool->quit) break;
+        generation = pool->generation;
+
+        /// workers that are not needed for this job go back to sleep
+        if (worker->index >= pool->ranges) continue;
+
+        spMutexUnlock(&pool->mutex);
+        runRange(pool, worker->index);
+        spMutexLock(&pool->mutex);
+
+        /// the last worker to finish wakes the calling thread
+        if (--pool->pending == 0)
+        {
+            spConditionSignal(&pool->done);
+        }
+    }
+    spMutexUnlock(&pool->mutex);
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI
+workerMain(LPVOID worker)
+{
+    workerLoop((spThreadPoolWorker*) worker);
+    return 0;
+}
+#else
+static void*
+workerMain(void* worker)
+{
+    workerLoop((spThreadPoolWorker*) worker);
+    return NULL;
+}
+#endif
+
+spThreadPool*
+spThreadPoolNew(spInt threadCount)
+{
+    spAssert(threadCount > 0, "thread pool needs at least one thread\n");
+    spThreadPool* pool = (spThreadPool*) spMalloc(sizeof(spThreadPool));
+    NULLCHECK(pool);
+
+    spMutexInit(&pool->mutex);
+    spConditionInit(&pool->wake);
+    spConditionInit(&pool->done);
+    pool->func = NULL;
+    pool->context = NULL;
+    pool->tasks = NULL;
+    pool->taskCapacity = 0;
+    pool->taskFunc = NULL;
+    pool->taskContext = NULL;
+    pool->count = 0;
+    pool->ranges = 0;
+    pool->pending = 0;
+    pool->generation = 0;
+    pool->threadCount = threadCount;
+    pool->quit = spFalse;
+
+    pool->deques = (spTaskDeque*) spMalloc(sizeof(spTaskDeque) * threadCount);
+    NULLCHECK(pool->deques);
+    for (spInt i = 0; i < threadCount; ++i)
+    {
+        spMutexInit(&pool->deques[i].mutex);
+        pool->deques[i].front = pool->deques[i].back = pool->deques[i].cost = 0;
+    }
+
+    /// the calling thread is thread 0, so only threadCount - 1 workers are started
+    pool->workers = NULL;
+    if (threadCount > 1)
+    {
+        pool->workers = (spThreadPoolWorker*) spMalloc(sizeof(spThreadPoolWorker) * (threadCount - 1));
+        NULLCHECK(pool->workers);
+    }
+    for (spInt i = 0; i < threadCount - 1; ++i)
+    {
+        spThreadPoolWorker* worker = pool->workers + i;
+        worker->pool = pool;
+        worker->index = i + 1;
+#if defined(_WIN32)
+        worker->thread = CreateThread(NULL, 0, workerMain, worker, 0, NULL);
+#else
+        pthread_create(&worker->thread, NULL, workerMain, worker);
+#endif
+    }
+    return pool;
+}
+
+void
+spThreadPoolFree(spThreadPool** pool)
+{
+    NULLCHECK(*pool);
+    spThreadPool* p = *pool;
+
+    /// wake every worker and wait for them to exit
+    spMutexLock(&p->mutex);
+    p->quit = spTrue;
+    spConditionBroadcast(&p->wake);
+    spMutexUnlock(&p->mutex);
+
+    for (spInt i = 0; i < p->threadCount - 1; ++i)
+    {
+#if defined(_WIN32)
+        WaitForSingleObject(p->workers[i].thread, INFINITE);
+        CloseHandle(p->workers[i].thread);
+#else
+        pthread_join(p->workers[i].thread, NULL);
+#endif
+    }
+
+    for (spInt i = 0; i < p->threadCount; ++i)
+    {
+        spMutexDestroy(&p->deques[i].mutex);
+    }
+    spFree(&p->deques);
+    if (p->tasks)
+    {
+        spFree(&p->tasks);
+    }
+
+    spConditionDestroy(&p->done);
+    spConditionDestroy(&p->wake);
+    spMutexDestroy(&p->mutex);
+    if (p->workers)
+    {
+        spFree(&p->workers);
+    }
+    spFree(pool);
+}
+
+void
+spThreadPoolParallelFor(spThreadPool* pool, spInt count, spInt grain, spParallelForFunc func, spLazyPointer context)
+{
+    NULLCHECK(pool); NULLCHECK(func);
+    if (count <= 0) return;
+
+    /// split the job into at most one range per thread, each with at least grain items
+    spInt ranges = grain > 0 ? count / grain : count;
+    ranges = ranges < pool->threadCount ? ranges : pool->threadCount;
+
+    /// not worth waking the workers, run it here
+    if (ranges <= 1)
+    {
+        func(context, 0, count, 0);
+        return;
+    }
+
+    /// post the job
+    spMutexLock(&pool->mutex);
+    pool->func = func;
+    pool->context = context;
+    pool->count = count;
+    pool->ranges = ranges;
+    pool->pending = ranges - 1;
+    pool->generation++;
+    spConditionBroadcast(&pool->wake);
+    spMutexUnlock(&pool->mutex);
+
+    /// the calling thread runs the first range
+    runRange(pool, 0);
+
+    /// wait for the workers to finish theirs
+    spMutexLock(&pool->mutex);
+    while (pool->pending > 0)
+    {
+        spConditionWait(&pool->done, &pool->mutex);
+    }
+    spMutexUnlock(&pool->mutex);
+}
+
+void
+spThreadPoolRunTasks(spThreadPool* pool, spInt count, const spInt* costs, spTaskFunc func, spLazyPointer context)
+{
+    NULLCHECK(pool); NULLCHECK(func);
+    if (count <= 0) return;
+
+    /// nobody to share with, run them in order here
+    spInt threads = pool->threadCount;
+    if (threads == 1 || count == 1)
+    {
+        for (spInt i = 0; i < count; ++i)
+        {
+            func(context, i, 0);
+        }
+        return;
+    }
+
+    /// the list holds a (cost, task) pair per task while dealing, and the dealt tasks after it
+    if (pool->taskCapacity < count)
+    {
+        while (pool->taskCapacity < count)
+        {
+            pool->taskCapacity = pool->taskCapacity ? pool->taskCapacity * 2 : 64;
+        }
+        pool->tasks = (spInt*) spRealloc(pool->tasks, sizeof(spInt) * 3 * pool->taskCapacity);
+        NULLCHECK(pool->tasks);
+    }
+    spInt* sorted = pool->tasks + pool->taskCapacity;
+    for (spInt i = 0; i < count; ++i)
+    {
+        sorted[i * 2 + 0] = costs ? costs[i] : 1;
+        sorted[i * 2 + 1] = i;
+    }
+    qsort(sorted, count, sizeof(spInt) * 2, compareTaskCost);
+
+    /// deal the biggest task left to the deque with the least work, then swap the cost for the deque it went to
+    for (spInt i = 0; i < threads; ++i)
+    {
+        pool->deques[i].cost = pool->deques[i].back = 0;
+    }
+    for (spInt i = 0; i < count; ++i)
+    {
+        spInt least = 0;
+        for (spInt j = 1; j < threads; ++j)
+        {
+            least = pool->deques[j].cost < pool->deques[least].cost ? j : least;
+        }
+        pool->deques[least].cost += sorted[i * 2 + 0];
+        pool->deques[least].back++;
+        sorted[i * 2 + 0] = least;
+    }
+
+    /// give each deque its slice of the task list, they keep the biggest first order
+    spInt start = 0;
+    for (spInt i = 0; i < threads; ++i)
+    {
+        spTaskDeque* deque = pool->deques + i;
+        deque->front = start;
+        start += deque->back;
+        deque->back = deque->front;
+    }
+    for (spInt i = 0; i < count; ++i)
+    {
+        spTaskDeque* deque = pool->deques + sorted[i * 2 + 0];
+        pool->tasks[deque->back++] = sorted[i * 2 + 1];
+    }
+
+    /// every thread drains its deque and then steals
+    pool->taskFunc = func;
+    pool->taskContext = context;
+    spThreadPoolParallelFor(pool, threads, 1, (spParallelForFunc)runTasks, pool);
+}
+
+spInt
+spThreadPoolGetThreadCount(spThreadPool* pool)
+{
+    NULLCHECK(pool);
+    return pool->threadCount;
+}
+
+spInt
+spGetProcessorCount()
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (spInt) info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (spInt) count : 1;
+#endif
+}
@@ -3,14 +3,57 @@
 #include "spConstraint.h"
 #include "spCollision.h"
 #include "spContact.h"
+#include "spContactSolver.h"
 #include "spBody.h"
 
 /// for each iters
 #define foreach_constraint(joint, initializer) for (spConstraint* joint = initializer; joint != NULL; joint = joint->next)
-#define foreach_contact(contact, initializer) for (spContact* contact = initializer; contact != NULL; contact = contact->next)
+#define foreach_contact(contact, pairs) for (spContact* contact = (pairs).contacts; contact != (pairs).contacts + (pairs).count; ++contact)
 #define foreach_shape(shape, initializer) for (spShape* shape = initializer; shape; shape = shape->next)
 #define foreach_body(body, initializer) for (spBody* body = initializer; body; body = body->next)
 
+/// context used while finding pairs between a shape and the shapes in the other structure
+typedef struct
+{
+    spWorld* world; ///< the world
+    spShape* shape; ///< the shape that was inserted or moved
+} StaticPairContext;
+
+/// context used to forward static tree queries to a shape query callback
+typedef struct
+{
+    spWorld* world;                 ///< the world
+    spBroadPhaseQueryCallback func; ///< shape callback
+    spLazyPointer context;          ///< shape callback context
+} StaticQueryContext;
+
+/// context used while solving a graph colored island a range at a time
+typedef struct
+{
+    spWorld* world;      ///< the world
+    spIsland* island;    ///< the island being solved
+    spGraphColor* color; ///< the color being solved
+    spFloat h;           ///< the time step
+    spInt wideStart[SP_GRAPH_COLORS + 1]; ///< first wide constraint of each color, the last is the total
+} ColorContext;
+
+/// context used while sweeping a bullet shape against the shapes around its path
+typedef struct
+{
+    spWorld* world;  ///< the world
+    spShape* shape;  ///< the bullet shape being swept
+    spShape* bullet; ///< the bullet shape that hit first
+    spShape* hit;    ///< the shape it hit, NULL if nothing was hit
+    spVector p0, p1; ///< position of the bullet at the start and end of the sweep
+    spFloat a0, a1;  ///< angle of the bullet at the start and end of the sweep
+    spFloat toi;     ///< earliest time of impact as a fraction of the sweep, 1 if nothing was hit
+    spBool substep;  ///< spTrue if the bullet already hit something this step
+    spFloat start;   ///< fraction of the step that passed before the sweep starts
+    spBody* other;   ///< body of the shape being tested when it moved this step, NULL if it is treated as resting
+    spVector q0, q1; ///< position of the other body at the start and end of the step
+    spFloat b0, b1;  ///< angle of the other body at the start and end of the step
+} TOIContext;
+
 /// static funcs
 
 static void 
@@ -24,32 +67,902 @@ initContact(spCollisionResult* result, spContact* contact, spShape* shapeA, spSh
     spBody* bodyA = shapeA->body;
 	spBody* bodyB = shapeB->body;
 
+    /// keep the old points to match the new ones against
+    spContactPoint oldPoints[2] = { contact->points[0], contact->points[1] };
+    spInt oldCount = contact->count;
+
     /// init the contact info
     contact->count = result->count;
 	contact->normal = result->normal;
     contact->friction = spsqrt(matA->friction * matB->friction);
     contact->restitution = spMax(matA->restitution, matB->restitution);
 
-    /// get rel velocity of contact points
-	for (spInt i = 0; i < contact->count; i++)
-	{
-        contact->points[i].rA = spvSub(result->pointA[i], bodyA->p);
-        contact->points[i].rB = spvSub(result->pointB[i], bodyB->p);
-	}
+    /// get rel velocity of contact points
+	for (spInt i = 0; i < contact->count; i++)
+	{
+        spContactPoint* point = contact->points + i;
+        point->rA = spvSub(result->pointA[i], bodyA->p);
+        point->rB = spvSub(result->pointB[i], bodyB->p);
+        point->id = result->id[i];
+        point->lambdaAccumNorm = 0.0f;
+        point->lambdaAccumTang = 0.0f;
+
+        /// a point made by the same features last step keeps its impulses, so it can be warm started
+        for (spInt j = 0; j < oldCount; ++j)
+        {
+            if (oldPoints[j].id == point->id)
+            {
+                point->lambdaAccumNorm = oldPoints[j].lambdaAccumNorm;
+                point->lambdaAccumTang = oldPoints[j].lambdaAccumTang;
+                break;
+            }
+        }
+	}
+}
+
+static void
+addPair(spWorld* world, spShape* shapeA, spShape* shapeB)
+{
+    spBody* bodyA = shapeA->body;
+    spBody* bodyB = shapeB->body;
+
+    /// shapes attached to the same body never collide
+    if (bodyA == bodyB) return;
+
+    /// static bodies never collide with each other
+    if (bodyA->type == SP_BODY_STATIC && bodyB->type == SP_BODY_STATIC) return;
+
+    /// check if the two shapes can collide (via collision filters)
+    if (spShapesCanCollide(shapeA, shapeB) == spFalse) return;
+
+    /// add a contact for the pair, nothing happens if it already exists
+    spPairManagerAdd(&world->pairs, spContactKeyConstruct(shapeA, shapeB));
+}
+
+static void
+removePair(spWorld* world, spShape* shapeA, spShape* shapeB)
+{
+    /// destroy the contact of the two shapes if it exists
+    spPairManagerRemove(&world->pairs, spContactKeyConstruct(shapeA, shapeB));
+}
+
+static INLINE spBool
+isStatic(spShape* shape)
+{
+    return shape->body->type == SP_BODY_STATIC;
+}
+
+static void
+wake(spBody* body)
+{
+    /// waking an awake body would reset its sleep timer, joints can be missing a body
+    if (body && body->awake == spFalse)
+    {
+        spBodySetAwake(body, spTrue);
+    }
+}
+
+static spBool
+contactAsleep(spContact* contact)
+{
+    /// static bodies are never awake, so a contact is only simulated if one of its bodies is awake
+    return contact->key.shapeA->body->awake == spFalse && contact->key.shapeB->body->awake == spFalse;
+}
+
+static spBool
+proxiesOverlap(spWorld* world, spContact* contact)
+{
+    /// contacts are kept alive while the shapes proxies overlap
+    spShape* shapeA = contact->key.shapeA;
+    spShape* shapeB = contact->key.shapeB;
+
+    /// the broadphase decides for its own proxies, so custom broadphases keep pairs alive the same way they find them
+    if (isStatic(shapeA) == spFalse && isStatic(shapeB) == spFalse)
+    {
+        return spBroadPhaseTestOverlap(world->broadPhase, shapeA->proxyId, shapeB->proxyId);
+    }
+
+    /// pairs with a static shape span both structures, every shape keeps the fat box of its proxy
+    return spAABBOverlap(&shapeA->aabb, &shapeB->aabb);
+}
+
+static spBool
+staticPairFunc(StaticPairContext* pairs, spInt proxyId)
+{
+    spShape* staticShape = (spShape*) spDynamicTreeGetData(&pairs->world->staticTree, proxyId);
+    addPair(pairs->world, pairs->shape, staticShape);
+    return spTrue;
+}
+
+static spBool
+broadPhasePairFunc(StaticPairContext* pairs, spShape* shape)
+{
+    addPair(pairs->world, pairs->shape, shape);
+    return spTrue;
+}
+
+static spBool
+staticQueryFunc(StaticQueryContext* query, spInt proxyId)
+{
+    spShape* staticShape = (spShape*) spDynamicTreeGetData(&query->world->staticTree, proxyId);
+    return query->func(query->context, staticShape);
+}
+
+static void
+collideRange(spWorld* world, spInt begin, spInt end, spInt thread)
+{
+    spContact* contacts = world->pairs.contacts;
+
+    /// circle pairs are gathered into this ranges part of the scratch list and collided as a batch
+    spInt* circlePairs = world->circlePairs + begin;
+    spInt circleCount = 0;
+
+    for (spInt i = begin; i < end; ++i)
+    {
+        spContact* contact = contacts + i;
+
+        /// get the contact key and shapes to collide
+        spContactKey* key     = &contact->key;
+        spShape*      shapeA  = key->shapeA;
+        spShape*      shapeB  = key->shapeB;
+
+        /// sleeping pairs keep their contact from the step they fell asleep
+        if (contactAsleep(contact)) continue;
+
+        if (shapeA->type == SP_SHAPE_CIRCLE && shapeB->type == SP_SHAPE_CIRCLE)
+        {
+            circlePairs[circleCount++] = i;
+            continue;
+        }
+
+        /// collide the two shapes, only this thread touches the contacts cache and result slot
+        contact->cache.sat = world->polygonSAT;
+        world->results[i] = spCollide(shapeA, shapeB, &contact->cache);
+    }
+
+    /// an empty world has no contact or scratch arrays yet, so the batch is only collided when it has pairs
+    if (circleCount > 0)
+    {
+        spCollideCircleBatch(contacts, circlePairs, circleCount, world->results);
+    }
+}
+
+static spBool
+movedThisStep(spBody* body)
+{
+    /// awake dynamic and kinematic bodies were integrated this step, from p0 and a0 to where they are now
+    return body->type != SP_BODY_STATIC && body->awake;
+}
+
+static spFloat
+farthestMotion(spWorld* world)
+{
+    /// the farthest any point of a moving body got from where it was at the start of the step
+    spFloat farthest = 0.0f;
+    foreach_body(body, world->bodyList)
+    {
+        if (movedThisStep(body) == spFalse) continue;
+
+        spFloat turn = spAbs(body->a - body->a0);
+        spFloat distance = spDistance(body->p0, body->p);
+        foreach_shape(shape, body->shapes)
+        {
+            farthest = spMax(farthest, distance + turn * spShapeGetReach(shape));
+        }
+    }
+    return farthest;
+}
+
+static void
+lerpBody(spBody* body, spVector p0, spVector p1, spFloat a0, spFloat a1, spFloat t)
+{
+    body->p = spvLerp(p0, p1, t);
+    body->a = a0 + (a1 - a0) * t;
+    spBodyUpdateTransform(body);
+}
+
+static void
+sweepBody(TOIContext* sweep, spBody* body, spFloat t)
+{
+    /// move the body to a fraction of its sweep
+    lerpBody(body, sweep->p0, sweep->p1, sweep->a0, sweep->a1, t);
+
+    /// the other body is moved to the same moment, the sweep only covers the part of the step after start
+    if (sweep->other)
+    {
+        lerpBody(sweep->other, sweep->q0, sweep->q1, sweep->b0, sweep->b1, sweep->start + (1.0f - sweep->start) * t);
+    }
+}
+
+static spFloat
+advance(TOIContext* sweep, spShape* other, spFloat motion)
+{
+    spBody* body = sweep->shape->body;
+    spCollisionCache cache;
+    spCollisionCacheInit(&cache);
+    cache.sat = sweep->world->polygonSAT;
+
+    /// conservative advancement, step forward by the gap over the motion so the shapes never pass each other
+    spFloat t = 0.0f;
+    for (spInt i = 0; i < SP_TOI_ITERATIONS; ++i)
+    {
+        sweepBody(sweep, body, t);
+        spFloat distance = spCollisionDistance(sweep->shape, other, &cache);
+        if (distance < SP_TOI_TARGET && i > 0)
+        {
+            return t;
+        }
+
+        /// shapes touching at the start of the step that have contact points were already handled by the solver,
+        /// otherwise the bullet is stopped right away so it cannot turn or slip through the shape
+        if (distance < SP_TOI_TARGET)
+        {
+            spContact* contact = spPairManagerFind(&sweep->world->pairs, spContactKeyConstruct(sweep->shape, other));
+            return sweep->substep == spFalse && contact && contact->count > 0 ? 1.0f : 0.0f;
+        }
+
+        t += (distance - 0.5f * SP_TOI_TARGET) / motion;
+        if (t >= sweep->toi) return 1.0f;
+    }
+    return t;
+}
+
+static spFloat
+timeOfImpact(TOIContext* sweep, spShape* other)
+{
+    /// the most the gap can close over the whole sweep, first from the bullet moving
+    spFloat motion = spDistance(sweep->p0, sweep->p1) + spAbs(sweep->a1 - sweep->a0) * spShapeGetReach(sweep->shape);
+
+    /// a body that moved this step too is swept from its old pose over the same part of the step, and its
+    /// motion is added. static and sleeping bodies stay where they are
+    spBody* body = other->body;
+    sweep->other = NULL;
+    if (movedThisStep(body))
+    {
+        sweep->other = body;
+        sweep->q0 = body->p0;
+        sweep->q1 = body->p;
+        sweep->b0 = body->a0;
+        sweep->b1 = body->a;
+        motion += (1.0f - sweep->start) * (spDistance(body->p0, body->p) + spAbs(body->a - body->a0) * spShapeGetReach(other));
+    }
+    if (motion <= SP_TOI_TARGET) return 1.0f;
+
+    spFloat toi = advance(sweep, other, motion);
+
+    /// put the other body back where the step left it
+    if (sweep->other)
+    {
+        body->p = sweep->q1;
+        body->a = sweep->b1;
+        spBodyUpdateTransform(body);
+        sweep->other = NULL;
+    }
+    return toi;
+}
+
+static spBool
+toiQueryFunc(TOIContext* sweep, spShape* shape)
+{
+    /// skip the bullets own shapes, and shapes it cannot collide with
+    if (shape->body == sweep->shape->body) return spTrue;
+    if (spShapesCanCollide(sweep->shape, shape) == spFalse) return spTrue;
+
+    /// keep the earliest hit
+    spFloat toi = timeOfImpact(sweep, shape);
+    if (toi < sweep->toi)
+    {
+        sweep->toi = toi;
+        sweep->bullet = sweep->shape;
+        sweep->hit = shape;
+    }
+    return spTrue;
+}
+
+static void
+solveImpact(spWorld* world, spShape* shapeA, spShape* shapeB, spFloat h)
+{
+    /// the shapes were left just apart, so the contact needs a margin to get its points
+    spContact contact;
+    spContactInit(&contact, spContactKeyConstruct(shapeA, shapeB));
+    contact.cache.margin = 2.0f * SP_TOI_TARGET;
+    contact.cache.sat = world->polygonSAT;
+
+    spCollisionResult result = spCollide(contact.key.shapeA, contact.key.shapeB, &contact.cache);
+    if (result.colliding == spFalse) return;
+
+    /// solve the contact on its own to take out the approaching velocity. it does not bounce here,
+    /// the regular contact made next step handles restitution
+    initContact(&result, &contact, contact.key.shapeA, contact.key.shapeB);
+    contact.restitution = 0.0f;
+    spContactPreSolve(&contact, h);
+    for (spInt i = 0; i < world->iterations; ++i)
+    {
+        spContactSolve(&contact);
+    }
+}
+
+static void
+solveBullet(spWorld* world, spBody* body, spFloat h, spFloat farthest)
+{
+    spFloat remaining = h;
+    for (spInt step = 0; step < SP_TOI_SUBSTEPS; ++step)
+    {
+        TOIContext sweep = { world, NULL, NULL, NULL, body->p0, body->p, body->a0, body->a, 1.0f, step > 0, 1.0f - remaining / h, NULL };
+
+        /// sweep every shape against the shapes around its path
+        foreach_shape(shape, body->shapes)
+        {
+            sweepBody(&sweep, body, 0.0f);
+            spAABB start = spShapeComputeAABB(shape);
+            sweepBody(&sweep, body, 1.0f);
+            spAABB end = spShapeComputeAABB(shape);
+
+            /// the shape can swing out of the two boxes while rotating, at most by its reach times the angle. the
+            /// proxies of moving shapes are from the start of the step, so the box also grows by the farthest they moved
+            spAABB box = spAABBUnion(&start, &end);
+            box = spAABBFatten(&box, spAbs(sweep.a1 - sweep.a0) * spShapeGetReach(shape) + farthest);
+
+            sweep.shape = shape;
+            spWorldQuery(world, &box, (spBroadPhaseQueryCallback)toiQueryFunc, &sweep);
+        }
+
+        /// nothing was hit, leave the bullet at the end of its sweep
+        sweepBody(&sweep, body, sweep.toi);
+        if (sweep.hit == NULL) return;
+
+        /// stop the bullet at the time of impact, and resolve the impact with the shape it hit moved to the same
+        /// moment. a dynamic body it hit is stopped there too, otherwise it would carry on through the bullet.
+        /// kinematic bodies follow their own path, so they go back to the end of it
+        spBody* hit = sweep.hit->body;
+        spVector p = hit->p;
+        spFloat a = hit->a;
+        if (movedThisStep(hit))
+        {
+            lerpBody(hit, hit->p0, p, hit->a0, a, sweep.start + (1.0f - sweep.start) * sweep.toi);
+        }
+        solveImpact(world, sweep.bullet, sweep.hit, h);
+        if (movedThisStep(hit) && hit->type == SP_BODY_KINEMATIC)
+        {
+            hit->p = p;
+            hit->a = a;
+            spBodyUpdateTransform(hit);
+        }
+
+        /// out of sub steps, the rest of the step is dropped
+        if (step + 1 == SP_TOI_SUBSTEPS) return;
+
+        /// move the bullet for the rest of the step with its new velocity, and sweep that too
+        remaining *= 1.0f - sweep.toi;
+        spBodyIntegratePosition(body, remaining);
+    }
+}
+
+static spBool
+bodyPushed(spBody* body)
+{
+    /// bodies are put to sleep without velocity or force, the user changed them since
+    return body->v.x != 0.0f || body->v.y != 0.0f || body->w != 0.0f ||
+           body->f.x != 0.0f || body->f.y != 0.0f || body->t != 0.0f;
+}
+
+static spBool
+islandAwake(spWorld* world, spIsland* island)
+{
+    spIslandGraph* graph = &world->islands;
+
+    for (spInt i = 0; i < island->bodyCount; ++i)
+    {
+        spBody* body = graph->bodies[island->bodyStart + i];
+        if (body->awake || bodyPushed(body)) return spTrue;
+    }
+
+    /// kinematic bodies are not part of islands, a moving one wakes every island it touches
+    for (spInt i = 0; i < island->contactCount; ++i)
+    {
+        spContact* contact = world->pairs.contacts + graph->contacts[island->contactStart + i];
+        spBody* bodyA = contact->key.shapeA->body;
+        spBody* bodyB = contact->key.shapeB->body;
+        if ((bodyA->type == SP_BODY_KINEMATIC && bodyPushed(bodyA)) ||
+            (bodyB->type == SP_BODY_KINEMATIC && bodyPushed(bodyB)))
+        {
+            return spTrue;
+        }
+    }
+    return spFalse;
+}
+
+static void
+sleepIsland(spWorld* world, spIsland* island, spFloat h)
+{
+    /// time how long each body has been still
+    spBody** bodies = world->islands.bodies + island->bodyStart;
+    spFloat sleepTime = SP_INFINITY;
+    for (spInt i = 0; i < island->bodyCount; ++i)
+    {
+        spBody* body = bodies[i];
+        spBool still = spDot(body->v, body->v) <= SP_SLEEP_LINEAR_TOLERANCE * SP_SLEEP_LINEAR_TOLERANCE &&
+                       body->w * body->w <= SP_SLEEP_ANGULAR_TOLERANCE * SP_SLEEP_ANGULAR_TOLERANCE;
+        body->sleepTime = still ? body->sleepTime + h : 0.0f;
+        sleepTime = spMin(sleepTime, body->sleepTime);
+    }
+
+    /// the whole island has been still long enough, put it to sleep
+    if (world->sleeping && sleepTime >= SP_TIME_TO_SLEEP)
+    {
+        for (spInt i = 0; i < island->bodyCount; ++i)
+        {
+            spBodySetAwake(bodies[i], spFalse);
+        }
+    }
+}
+
+static void
+loadBodies(spWorld* world, spBody** bodies, spInt begin, spInt end)
+{
+    for (spInt i = begin; i < end; ++i)
+    {
+        spSolverBodyLoad(world->solverBodies + bodies[i]->islandNode, bodies[i]);
+    }
+}
+
+static void
+storeBodies(spWorld* world, spBody** bodies, spInt begin, spInt end)
+{
+    for (spInt i = begin; i < end; ++i)
+    {
+        spSolverBodyStore(world->solverBodies + bodies[i]->islandNode, bodies[i]);
+    }
+}
+
+static void
+solveIsland(spWorld* world, spIsland* island, spFloat h)
+{
+    spIslandGraph* graph = &world->islands;
+    spBody** bodies = graph->bodies + island->bodyStart;
+    spInt* contacts = graph->contacts + island->contactStart;
+    spConstraint** joints = graph->joints + island->jointStart;
+    spContactConstraint* constraints = world->contactConstraints + island->contactStart;
+    spSolverBody* solverBodies = world->solverBodies;
+    spContact* pairs = world->pairs.contacts;
+
+    /// pre step the constraints
+    for (spInt i = 0; i < island->jointCount; ++i)
+    {
+        joints[i]->funcs.preSolve(joints[i], h);
+    }
+
+    /// pre step the contacts and pack them next to each other
+    for (spInt i = 0; i < island->contactCount; ++i)
+    {
+        spContactPreSolve(pairs + contacts[i], h);
+        spContactConstraintInit(constraints + i, pairs + contacts[i], contacts[i]);
+    }
+
+    /// integrate forces and update velocity
+    for (spInt i = 0; i < island->bodyCount; ++i)
+    {
+        spBodyIntegrateVelocity(bodies[i], world->gravity, h);
+    }
+
+    /// warm start the joints
+    for (spInt i = 0; i < island->jointCount; ++i)
+    {
+        joints[i]->funcs.warmStart(joints[i]);
+    }
+
+    /// warm start the contacts, which only work on the solver bodies from here on
+    loadBodies(world, bodies, 0, island->bodyCount);
+    for (spInt i = 0; i < island->contactCount; ++i)
+    {
+        spContactConstraintWarmStart(constraints + i, solverBodies);
+    }
+
+    /// apply contact / joint impulses. joints work on the bodies, so the velocities are
+    /// copied back and forth around them, islands without joints never do this
+    for (spInt iteration = 0; iteration < world->iterations; ++iteration)
+    {
+        if (island->jointCount)
+        {
+            storeBodies(world, bodies, 0, island->bodyCount);
+            for (spInt i = 0; i < island->jointCount; ++i)
+            {
+                joints[i]->funcs.solve(joints[i]);
+            }
+            loadBodies(world, bodies, 0, island->bodyCount);
+        }
+
+        for (spInt i = 0; i < island->contactCount; ++i)
+        {
+            spContactConstraintSolve(constraints + i, solverBodies);
+        }
+    }
+    storeBodies(world, bodies, 0, island->bodyCount);
+    for (spInt i = 0; i < island->contactCount; ++i)
+    {
+        spContactConstraintStore(constraints + i, pairs);
+    }
+
+    /// integrate velocity and update position
+    for (spInt i = 0; i < island->bodyCount; ++i)
+    {
+        spBodyIntegratePosition(bodies[i], h);
+    }
+    sleepIsland(world, island, h);
+}
+
+static void
+preSolveRange(ColorContext* context, spInt begin, spInt end, spInt thread)
+{
+    spWorld* world = context->world;
+    spInt* contacts = world->coloring.contacts;
+    spContactConstraint* constraints = world->contactConstraints + context->island->contactStart;
+
+    /// the constraints are packed in color order, so each color is one range of them
+    for (spInt i = begin; i < end; ++i)
+    {
+        spContactPreSolve(world->pairs.contacts + contacts[i], context->h);
+        spContactConstraintInit(constraints + i, world->pairs.contacts + contacts[i], contacts[i]);
+    }
+}
+
+static void
+integrateVelocityRange(ColorContext* context, spInt begin, spInt end, spInt thread)
+{
+    spBody** bodies = context->world->islands.bodies + context->island->bodyStart;
+    for (spInt i = begin; i < end; ++i)
+    {
+        spBodyIntegrateVelocity(bodies[i], context->world->gravity, context->h);
+    }
+}
+
+static void
+integratePositionRange(ColorContext* context, spInt begin, spInt end, spInt thread)
+{
+    spBody** bodies = context->world->islands.bodies + context->island->bodyStart;
+    for (spInt i = begin; i < end; ++i)
+    {
+        spBodyIntegratePosition(bodies[i], context->h);
+    }
+}
+
+static void
+loadRange(ColorContext* context, spInt begin, spInt end, spInt thread)
+{
+    loadBodies(context->world, context->world->islands.bodies + context->island->bodyStart, begin, end);
+}
+
+static void
+storeRange(ColorContext* context, spInt begin, spInt end, spInt thread)
+{
+    storeBodies(context->world, context->world->islands.bodies + context->island->bodyStart, begin, end);
+}
+
+static void
+storeImpulsesRange(ColorContext* context, spInt begin, spInt end, spInt thread)
+{
+    spContactConstraint* constraints = context->world->contactConstraints + context->island->contactStart;
+    for (spInt i = begin; i < end; ++i)
+    {
+        spContactConstraintStore(constraints + i, context->world->pairs.contacts);
+    }
+}
+
+static void
+warmStartJointRange(ColorContext* context, spInt begin, spInt end, spInt thread)
+{
+    spConstraint** joints = context->world->coloring.joints + context->color->jointStart;
+    for (spInt i = begin; i < end; ++i)
+    {
+        joints[i]->funcs.warmStart(joints[i]);
+    }
+}
+
+static void
+solveJointRange(ColorContext* context, spInt begin, spInt end, spInt thread)
+{
+    spConstraint** joints = context->world->coloring.joints + context->color->jointStart;
+    for (spInt i = begin; i < end; ++i)
+    {
+        joints[i]->funcs.solve(joints[i]);
+    }
+}
+
+static spContactConstraint*
+colorConstraints(ColorContext* context)
+{
+    return context->world->contactConstraints + context->island->contactStart + context->color->contactStart;
+}
+
+static spWideContactConstraint*
+colorWideConstraints(ColorContext* context)
+{
+    return context->world->wideConstraints + context->wideStart[context->color - context->world->coloring.colors];
+}
+
+static void
+warmStartContactRange(ColorContext* context, spInt begin, spInt end, spInt thread)
+{
+    spContactConstraint* constraints = colorConstraints(context);
+    for (spInt i = begin; i < end; ++i)
+    {
+        spContactConstraintWarmStart(constraints + i, context->world->solverBodies);
+    }
+}
+
+static void
+solveContactRange(ColorContext* context, spInt begin, spInt end, spInt thread)
+{
+    spContactConstraint* constraints = colorConstraints(context);
+    for (spInt i = begin; i < end; ++i)
+    {
+        spContactConstraintSolve(constraints + i, context->world->solverBodies);
+    }
+}
+
+static void
+packWideRange(ColorContext* context, spInt begin, spInt end, spInt thread)
+{
+    spContactConstraint* constraints = colorConstraints(context);
+    spWideContactConstraint* wide = colorWideConstraints(context);
+    for (spInt i = begin; i < end; ++i)
+    {
+        spInt count = context->color->contactCount - i * SP_WIDE_LANES;
+        count = count < SP_WIDE_LANES ? count : SP_WIDE_LANES;
+        spWideContactConstraintInit(wide + i, constraints + i * SP_WIDE_LANES, count, context->world->solverBodies);
+    }
+}
+
+static void
+warmStartWideRange(ColorContext* context, spInt begin, spInt end, spInt thread)
+{
+    spWideContactConstraint* wide = colorWideConstraints(context);
+    for (spInt i = begin; i < end; ++i)
+    {
+        spWideContactConstraintWarmStart(wide + i, context->world->solverBodies);
+    }
+}
+
+static void
+solveWideRange(ColorContext* context, spInt begin, spInt end, spInt thread)
+{
+    spWideContactConstraint* wide = colorWideConstraints(context);
+    for (spInt i = begin; i < end; ++i)
+    {
+        spWideContactConstraintSolve(wide + i, context->world->solverBodies);
+    }
+}
+
+static void
+storeWideRange(ColorContext* context, spInt begin, spInt end, spInt thread)
+{
+    spContactConstraint* constraints = colorConstraints(context);
+    spWideContactConstraint* wide = colorWideConstraints(context);
+    for (spInt i = begin; i < end; ++i)
+    {
+        spWideContactConstraintStore(wide + i, constraints + i * SP_WIDE_LANES);
+    }
+}
+
+static void
+parallelRange(spWorld* world, spInt count, spParallelForFunc func, ColorContext* context)
+{
+    if (world->threadPool)
+    {
+        spThreadPoolParallelFor(world->threadPool, count, SP_SOLVER_GRAIN, func, context);
+    }
+    else
+    {
+        func(context, 0, count, 0);
+    }
+}
+
+static void
+solveJointColors(spWorld* world, ColorContext* context, spParallelForFunc func)
+{
+    /// the joints of a color share no dynamic bodies, the overflow ones do and run on this thread
+    for (spInt i = 0; i <= SP_GRAPH_OVERFLOW; ++i)
+    {
+        context->color = world->coloring.colors + i;
+        if (i == SP_GRAPH_OVERFLOW)
+        {
+            func(context, 0, context->color->jointCount, 0);
+        }
+        else
+        {
+            parallelRange(world, context->color->jointCount, func, context);
+        }
+    }
+}
+
+static void
+solveContactColors(spWorld* world, ColorContext* context, spParallelForFunc wideFunc, spParallelForFunc func)
+{
+    /// with simd each color is split into wide constraints of four. the overflow contacts share bodies,
+    /// so they are never packed together, and run one at a time on this thread
+    for (spInt i = 0; i <= SP_GRAPH_OVERFLOW; ++i)
+    {
+        context->color = world->coloring.colors + i;
+        if (i == SP_GRAPH_OVERFLOW)
+        {
+            if (func) func(context, 0, context->color->contactCount, 0);
+        }
+        else if (world->simd)
+        {
+            parallelRange(world, context->wideStart[i + 1] - context->wideStart[i], wideFunc, context);
+        }
+        else if (func)
+        {
+            parallelRange(world, context->color->contactCount, func, context);
+        }
+    }
+}
+
+static void
+solveColoredIsland(spWorld* world, spIsland* island, spFloat h)
+{
+    spConstraint** joints = world->islands.joints + island->jointStart;
+    ColorContext context = { world, island, NULL, h };
+    spGraphColoringBuild(&world->coloring, &world->islands, island, world->pairs.contacts);
+
+    /// give each color enough wide constraints for its contacts
+    context.wideStart[0] = 0;
+    for (spInt i = 0; i < SP_GRAPH_COLORS; ++i)
+    {
+        spInt count = world->simd ? (world->coloring.colors[i].contactCount + SP_WIDE_LANES - 1) / SP_WIDE_LANES : 0;
+        context.wideStart[i + 1] = context.wideStart[i] + count;
+    }
+    if (world->wideCapacity < context.wideStart[SP_GRAPH_COLORS])
+    {
+        while (world->wideCapacity < context.wideStart[SP_GRAPH_COLORS])
+        {
+            world->wideCapacity = world->wideCapacity ? world->wideCapacity * 2 : 64;
+        }
+        world->wideConstraints = (spWideContactConstraint*) spRealloc(world->wideConstraints, sizeof(spWideContactConstraint) * world->wideCapacity);
+        NULLCHECK(world->wideConstraints);
+    }
+
+    /// pre step the constraints, some joints change their bodies here so they stay on this thread
+    for (spInt i = 0; i < island->jointCount; ++i)
+    {
+        joints[i]->funcs.preSolve(joints[i], h);
+    }
+    parallelRange(world, island->contactCount, (spParallelForFunc)preSolveRange, &context);
+
+    /// integrate forces and update velocity
+    parallelRange(world, island->bodyCount, (spParallelForFunc)integrateVelocityRange, &context);
+
+    /// warm start a color at a time, the contacts work on the solver bodies
+    solveJointColors(world, &context, (spParallelForFunc)warmStartJointRange);
+    parallelRange(world, island->bodyCount, (spParallelForFunc)loadRange, &context);
+    if (world->simd)
+    {
+        solveContactColors(world, &context, (spParallelForFunc)packWideRange, NULL);
+    }
+    solveContactColors(world, &context, (spParallelForFunc)warmStartWideRange, (spParallelForFunc)warmStartContactRange);
+
+    /// apply contact / joint impulses a color at a time
+    for (spInt iteration = 0; iteration < world->iterations; ++iteration)
+    {
+        if (island->jointCount)
+        {
+            parallelRange(world, island->bodyCount, (spParallelForFunc)storeRange, &context);
+            solveJointColors(world, &context, (spParallelForFunc)solveJointRange);
+            parallelRange(world, island->bodyCount, (spParallelForFunc)loadRange, &context);
+        }
+        solveContactColors(world, &context, (spParallelForFunc)solveWideRange, (spParallelForFunc)solveContactRange);
+    }
+    if (world->simd)
+    {
+        solveContactColors(world, &context, (spParallelForFunc)storeWideRange, NULL);
+    }
+    parallelRange(world, island->bodyCount, (spParallelForFunc)storeRange, &context);
+    parallelRange(world, island->contactCount, (spParallelForFunc)storeImpulsesRange, &context);
+
+    /// integrate velocity and update position
+    parallelRange(world, island->bodyCount, (spParallelForFunc)integratePositionRange, &context);
+    sleepIsland(world, island, h);
+}
+
+static void
+solveIslandTask(spWorld* world, spInt task, spInt thread)
+{
+    solveIsland(world, world->islands.islands + world->islandTasks[task], world->stepSize);
+}
+
+static spFloat
+speculativeMargin(spContact* contact, spFloat h)
+{
+    spShape* shapeA = contact->key.shapeA;
+    spShape* shapeB = contact->key.shapeB;
+    spBody* bodyA = shapeA->body;
+    spBody* bodyB = shapeB->body;
+
+    /// the fastest the shapes can approach each other, from their relative velocity and spin
+    spFloat speed = spvLength(spvSub(bodyB->v, bodyA->v)) +
+                    spAbs(bodyA->w) * spShapeGetReach(shapeA) +
+                    spAbs(bodyB->w) * spShapeGetReach(shapeB);
+
+    return speed * h + spSlop;
+}
+
+static spAABB
+predictAABB(spWorld* world, spShape* shape)
+{
+    spAABB aabb = spShapeComputeAABB(shape);
+    if (world->speculative == spFalse) return aabb;
+
+    /// stretch the box over where the shape will be after a step at its current velocity, so speculative
+    /// contacts exist for pairs that can meet during the step, not only for pairs whose fat boxes already touch
+    spBody* body = shape->body;
+    spVector delta = spvfMult(body->v, world->stepSize);
+    spAABB moved = spAABBConstruct(spvAdd(aabb.min, delta), spvAdd(aabb.max, delta));
+    aabb = spAABBUnion(&aabb, &moved);
+    return spAABBFatten(&aabb, spAbs(body->w) * world->stepSize * spShapeGetReach(shape));
+}
+
+static void
+updateBodyAABB(spBody* body)
+{
+    /// union the fat boxes of every shape that has a proxy
+    spBool empty = spTrue;
+    foreach_shape(shape, body->shapes)
+    {
+        if (shape->proxyId == -1) continue;
+
+        body->aabb = empty ? shape->aabb : spAABBUnion(&body->aabb, &shape->aabb);
+        empty = spFalse;
+    }
 }
 
 static void
-addContact(spWorld* world, spContact* contact)
+insertProxy(spWorld* world, spShape* shape)
 {
-    SP_LINKED_LIST_PREPEND(spContact, contact, world->contactList);
+    spAABB aabb = predictAABB(world, shape);
+    shape->aabb = spAABBFatten(&aabb, world->aabbMargin);
+
+    /// the broadphase only pairs its own proxies, so find pairs with the other structure here
+    StaticPairContext pairs = { world, shape };
+    if (isStatic(shape))
+    {
+        shape->proxyId = spDynamicTreeInsertProxy(&world->staticTree, &shape->aabb, shape);
+        spBroadPhaseQuery(world->broadPhase, &shape->aabb, (spBroadPhaseQueryCallback)broadPhasePairFunc, &pairs);
+    }
+    else
+    {
+        shape->proxyId = spBroadPhaseInsert(world->broadPhase, shape, &shape->aabb);
+        spDynamicTreeQuery(&world->staticTree, &shape->aabb, (spTreeQueryFunc)staticPairFunc, &pairs);
+    }
+    updateBodyAABB(shape->body);
 }
 
-static void 
-destroyContact(spWorld* world, spContact** destroy)
+static spBool
+updateFatAABB(spWorld* world, spShape* shape)
+{
+    spAABB aabb = predictAABB(world, shape);
+
+    /// the shape is still inside of its fat box, its proxy does not need to move
+    if (spAABBContains(&shape->aabb, &aabb))
+    {
+        return spFalse;
+    }
+    shape->aabb = spAABBFatten(&aabb, world->aabbMargin);
+    return spTrue;
+}
+
+static void
+removeProxy(spWorld* world, spShape* shape)
 {
-    spContact* contact = *destroy;
-    SP_LINKED_LIST_REMOVE(spContact, contact, world->contactList);
-    spContactFree(destroy);
+    if (isStatic(shape))
+    {
+        spDynamicTreeRemoveProxy(&world->staticTree, shape->proxyId);
+    }
+    else
+    {
+        spBroadPhaseRemove(world->broadPhase, shape->proxyId);
+    }
+    shape->proxyId = -1;
+    updateBodyAABB(shape->body);
 }
 
 /// world functions
@@ -61,20 +974,50 @@ spWorldInit(spWorld* world, spInt iterations, spVector gravity)
     world->gravity = gravity;
     world->jointList = NULL;
     world->bodyList  = NULL;
-    world->contactList = NULL;
-    world->sweepAndPrune = spSapConstruct();
+    world->pairs = spPairManagerConstruct();
+    world->broadPhase = spTreeBroadPhaseNew();
+    world->staticTree = spDynamicTreeConstruct();
+    world->gridCellSize = SP_GRID_CELL_SIZE;
+    world->aabbMargin = SP_AABB_EXTENSION;
+    world->gjkIterations = 0;
+    world->speculative = spFalse;
+    world->polygonSAT = spTrue;
+    world->stepSize = 0.0f;
+    world->sleeping = spTrue;
+    world->islands = spIslandGraphConstruct();
+    world->islandTasks = NULL;
+    world->islandCosts = NULL;
+    world->islandCapacity = 0;
+    world->coloring = spGraphColoringConstruct();
+    world->solverBodies = NULL;
+    world->contactConstraints = NULL;
+    world->solverBodyCapacity = 0;
+    world->constraintCapacity = 0;
+    world->wideConstraints = NULL;
+    world->wideCapacity = 0;
+    world->simd = spContactSolverHasSIMD();
+    world->results = NULL;
+    world->circlePairs = NULL;
+    world->resultCapacity = 0;
+    world->threadPool = NULL;
+
+    /// the world fattens the boxes itself
+    spDynamicTreeSetMargin(&world->staticTree, 0.0f);
 }
 
 void 
 spWorldDestroy(spWorld* world)
 {
     /// destroy all contacts
-    spContact* contact = world->contactList;
-    while(contact)
+    spPairManagerDestroy(&world->pairs);
+
+    /// destroy all constraints first, removing one wakes its bodies
+    spConstraint* constraint = world->jointList;
+    while(constraint)
     {
-        spContact* next = contact->next;
-        destroyContact(world, &contact);
-        contact = next;
+        spConstraint* next = constraint->next;
+        spConstraintFree(&constraint);
+        constraint = next;
     }
 
     /// destroy all bodies
@@ -86,19 +1029,43 @@ spWorldDestroy(spWorld* world)
         body = next;
     }
 
-    /// destroy all constraints
-    spConstraint* constraint = world->jointList;
-    while(constraint)
-    {
-        spConstraint* next = constraint->next;
-        spConstraintFree(&constraint);
-        constraint = next;
-    }
-
-    world->contactList = NULL;
     world->jointList = NULL;
     world->bodyList = NULL;
-    spSapDestroy(&world->sweepAndPrune);
+    spBroadPhaseFree(&world->broadPhase);
+    spDynamicTreeDestroy(&world->staticTree);
+    spIslandGraphDestroy(&world->islands);
+    if (world->islandTasks)
+    {
+        spFree(&world->islandTasks);
+        spFree(&world->islandCosts);
+    }
+    world->islandCapacity = 0;
+    spGraphColoringDestroy(&world->coloring);
+    if (world->solverBodies)
+    {
+        spFree(&world->solverBodies);
+    }
+    if (world->contactConstraints)
+    {
+        spFree(&world->contactConstraints);
+    }
+    world->solverBodyCapacity = 0;
+    world->constraintCapacity = 0;
+    if (world->wideConstraints)
+    {
+        spFree(&world->wideConstraints);
+    }
+    world->wideCapacity = 0;
+    if (world->results)
+    {
+        spFree(&world->results);
+        spFree(&world->circlePairs);
+    }
+    world->resultCapacity = 0;
+    if (world->threadPool)
+    {
+        spThreadPoolFree(&world->threadPool);
+    }
     int x = 0;
 }
 
@@ -113,180 +1080,217 @@ spWorldConstruct(spInt iterations, spVector gravity)
 void 
 spWorldStep(spWorld* world, const spFloat h)
 {
+    world->stepSize = h;
+
     /// do broad phase collision detection
-    //spWorldBroadPhaseSAP(world);
-    spWorldBroadPhaseBruteForce(world);
+    spWorldBroadPhase(world);
+
+    /// give each pair a margin as big as the distance the bodies can close this step
+    if (world->speculative)
+    {
+        foreach_contact(contact, world->pairs)
+        {
+            if (contactAsleep(contact)) continue;
+            contact->cache.margin = speculativeMargin(contact, h);
+        }
+    }
 
     /// do narrow phase collision detection
     spWorldNarrowPhase(world);
 
-    /// pre step the constraints
-    foreach_constraint(joint, world->jointList)
+    /// group the bodies into islands, and find the islands that are awake or were touched by something awake
+    spIslandGraph* graph = &world->islands;
+    spIslandGraphBuild(graph, world->bodyList, world->jointList, world->pairs.contacts, world->pairs.count);
+    if (world->islandCapacity < graph->islandCount)
     {
-        joint->funcs.preSolve(joint, h);
+        while (world->islandCapacity < graph->islandCount)
+        {
+            world->islandCapacity = world->islandCapacity ? world->islandCapacity * 2 : 64;
+        }
+        world->islandTasks = (spInt*) spRealloc(world->islandTasks, sizeof(spInt) * world->islandCapacity);
+        world->islandCosts = (spInt*) spRealloc(world->islandCosts, sizeof(spInt) * world->islandCapacity);
+        NULLCHECK(world->islandTasks); NULLCHECK(world->islandCosts);
     }
-
-    /// pre step the contacts
-    foreach_contact(contact, world->contactList)
+    if (world->solverBodyCapacity < graph->bodyCount)
     {
-        spContactPreSolve(contact, h);
+        while (world->solverBodyCapacity < graph->bodyCount)
+        {
+            world->solverBodyCapacity = world->solverBodyCapacity ? world->solverBodyCapacity * 2 : 64;
+        }
+        world->solverBodies = (spSolverBody*) spRealloc(world->solverBodies, sizeof(spSolverBody) * world->solverBodyCapacity);
+        NULLCHECK(world->solverBodies);
     }
-
-    /// integrate forces and update velocity
-    foreach_body(body, world->bodyList)
+    if (world->constraintCapacity < graph->contactCount)
     {
-        spBodyIntegrateVelocity(body, world->gravity, h);
+        while (world->constraintCapacity < graph->contactCount)
+        {
+            world->constraintCapacity = world->constraintCapacity ? world->constraintCapacity * 2 : 64;
+        }
+        world->contactConstraints = (spContactConstraint*) spRealloc(world->contactConstraints, sizeof(spContactConstraint) * world->constraintCapacity);
+        NULLCHECK(world->contactConstraints);
     }
 
-    /// warm start the joints
-    foreach_constraint(joint, world->jointList)
+    spInt taskCount = 0;
+    for (spInt i = 0; i < graph->islandCount; ++i)
     {
-        joint->funcs.warmStart(joint);
+        spIsland* island = graph->islands + i;
+        island->awake = islandAwake(world, island);
+        if (island->awake == spFalse) continue;
+
+        for (spInt j = 0; j < island->bodyCount; ++j)
+        {
+            wake(graph->bodies[island->bodyStart + j]);
+        }
+
+        /// big islands are colored and solved below
+        if (island->contactCount + island->jointCount >= SP_COLORING_MIN_CONSTRAINTS) continue;
+        world->islandTasks[taskCount] = i;
+        world->islandCosts[taskCount] = island->bodyCount + (island->contactCount + island->jointCount) * world->iterations;
+        ++taskCount;
     }
 
-    /// pre step the contacts
-    foreach_contact(contact, world->contactList)
+    /// islands only touch their own bodies and constraints, so they can be solved in any order on any thread
+    if (world->threadPool)
+    {
+        spThreadPoolRunTasks(world->threadPool, taskCount, world->islandCosts, (spTaskFunc)solveIslandTask, world);
+    }
+    else
     {
-        spContactWarmStart(contact);
+        for (spInt i = 0; i < taskCount; ++i)
+        {
+            solveIslandTask(world, i, 0);
+        }
     }
 
-    /// apply contact / joint impulses
-    for (spInt i = 0; i < world->iterations; ++i)
+    /// big islands spread each color over the threads instead. they are colored even when single threaded
+    /// so the order their constraints are solved in, and so the result, does not depend on the thread count
+    for (spInt i = 0; i < graph->islandCount; ++i)
     {
-        foreach_constraint(joint, world->jointList)
+        spIsland* island = graph->islands + i;
+        if (island->awake && island->contactCount + island->jointCount >= SP_COLORING_MIN_CONSTRAINTS)
         {
-            joint->funcs.solve(joint);
+            solveColoredIsland(world, island, h);
         }
+    }
 
-        foreach_contact(contact, world->contactList)
+    /// kinematic bodies are not in islands, move them on their own
+    foreach_body(body, world->bodyList)
+    {
+        if (body->type == SP_BODY_KINEMATIC && body->awake)
         {
-            spContactSolve(contact);
+            spBodyIntegratePosition(body, h);
         }
     }
 
-    /// integrate velocity and update position
+    /// sweep bullets so they stop at the first shape they hit instead of passing through it
+    spFloat farthest = -1.0f;
     foreach_body(body, world->bodyList)
     {
-        spBodyIntegratePosition(body, h);
+        if (body->bullet && body->type == SP_BODY_DYNAMIC && body->awake)
+        {
+            if (farthest < 0.0f) farthest = farthestMotion(world);
+            solveBullet(world, body, h, farthest);
+        }
     }
 }
 
-void 
-spWorldBroadPhaseSAP(spWorld* world)
+void
+spWorldBroadPhase(spWorld* world)
 {
-    spSap* sap = &world->sweepAndPrune;
-
-    /// update the sap boxes to world space
-    spSapUpdate(sap);
+    spBroadPhase* broadPhase = world->broadPhase;
 
-    /// quick sort the boxes to sort them spatially
-    spSapSort(sap);
+    StaticPairContext pairs;
+    pairs.world = world;
 
-    /// check for interval overlap and if have potential for collision
-    spInt count = sap->count;
-    spSapBox** boxes = sap->boxes;
-    for (spInt i = 0; i < count; ++i)
+    /// move the proxies of shapes that left their fat box, static and sleeping shapes have not moved
+    foreach_body(body, world->bodyList)
     {
-        spShape* shapeA = boxes[i]->shape;
-        for (spInt j = i + 1; j < count; ++j)
-        {
-            spShape* shapeB = boxes[j]->shape;
+        if (body->awake == spFalse) continue;
 
-            /// check if the intervals overlap
-            if (spIntervalsDontOverlap(boxes, i, j))
-            {
-                break;
-            }
-
-            /// check if the two shapes can collide
-            if (spShapesCanCollide(shapeA, shapeB) == spFalse) continue;
-
-            /// check if the two boxes overlap
-            if (spBoxesOverlap(boxes[i], boxes[j]) == spFalse) continue;
+        spBool moved = spFalse;
+        foreach_shape(shape, body->shapes)
+        {
+            if (updateFatAABB(world, shape) == spFalse) continue;
 
-            /// they do overlap, create a contact key
-            spContactKey key = spContactKeyConstruct(shapeA, shapeB);
+            spBroadPhaseMove(broadPhase, shape->proxyId, &shape->aabb);
+            moved = spTrue;
 
-            /// check if the contact key is currently in the contact list
-            if (spContactKeyExists(key, world->contactList) == spFalse && 
-               (spBodyGetType(shapeA->body) != SP_BODY_STATIC || 
-                spBodyGetType(shapeB->body) != SP_BODY_STATIC))
-            {
-                /// the contact key is not in the list, create a new contact with the key
-                spContact* contact = spContactNew(key);
+            /// find the static shapes the new fat box overlaps
+            pairs.shape = shape;
+            spDynamicTreeQuery(&world->staticTree, &shape->aabb, (spTreeQueryFunc)staticPairFunc, &pairs);
+        }
 
-                /// insert the contact into the contact list
-                addContact(world, contact);
-            }
+        if (moved)
+        {
+            updateBodyAABB(body);
         }
     }
+
+    /// create contacts for new pairs, and destroy the contacts of pairs that separated
+    spBroadPhaseUpdatePairs(broadPhase, (spBroadPhasePairCallback)addPair, (spBroadPhasePairCallback)removePair, world);
 }
 
 void 
-spWorldBroadPhaseBruteForce(spWorld* world)
+spWorldNarrowPhase(spWorld* world)
 {
-    foreach_body(body_a, world->bodyList) { foreach_body(body_b, body_a->next)
+    spPairManager* pairs = &world->pairs;
+    world->gjkIterations = 0;
+
+    /// grow the scratch buffers so every contact has a result slot
+    if (world->resultCapacity < pairs->count)
     {
-        foreach_shape(shape_a, body_a->shapes) { foreach_shape(shape_b, body_b->shapes)
+        while (world->resultCapacity < pairs->count)
         {
-            /// bounding boxes of shapeA and shapeB
-            spBound* ba = &shape_a->bound;
-            spBound* bb = &shape_b->bound;
-
-            /// check if the two shapes can collide (via collision filters)
-            if (spShapesCanCollide(shape_a, shape_b) == spFalse) continue;
-
-            /// check if the shapes AABB's overlap
-            if (spBoundBoxOverlap(ba, bb, &body_a->xf, &body_b->xf) == spFalse) continue;
-
-            /// they do overlap, create a contact key
-            spContactKey key = spContactKeyConstruct(shape_a, shape_b);
-
-            /// check if the contact key is currently in the contact list
-            if (spContactKeyExists(key, world->contactList) == spFalse && 
-               (body_a->type != SP_BODY_STATIC || body_b->type != SP_BODY_STATIC))
-            {
-                /// the contact key is not in the list, create a new contact with the key
-                spContact* contact = spContactNew(key);
+            world->resultCapacity = world->resultCapacity ? world->resultCapacity * 2 : 64;
+        }
+        world->results = (spCollisionResult*) spRealloc(world->results, sizeof(spCollisionResult) * world->resultCapacity);
+        world->circlePairs = (spInt*) spRealloc(world->circlePairs, sizeof(spInt) * world->resultCapacity);
+        NULLCHECK(world->results); NULLCHECK(world->circlePairs);
+    }
 
-                /// insert the contact into the contact list
-                addContact(world, contact);
-            }
-        }}
-    }}
-}
+    /// collide every pair into its result slot, split across the thread pool if the world has one
+    if (world->threadPool)
+    {
+        spThreadPoolParallelFor(world->threadPool, pairs->count, SP_NARROWPHASE_GRAIN, (spParallelForFunc)collideRange, world);
+    }
+    else
+    {
+        collideRange(world, 0, pairs->count, 0);
+    }
 
-void 
-spWorldNarrowPhase(spWorld* world)
-{
-    spContact* contact = world->contactList;
+    /// update the contacts with their results. this is serial, so the contact order
+    /// only depends on the results and not on how the pairs were split between threads
     spInt i = 0;
-    while (contact != NULL)
+    while (i < pairs->count)
     {
-        /// get the contact key and shapes to collide
-        spContactKey* key     = &contact->key;
-        spShape*      shapeA  = key->shapeA;
-        spShape*      shapeB  = key->shapeB;
-
-        /// collide the two shapes
-        spCollisionFunc Collide = CollideFunc[shapeA->type][shapeB->type];
-        spCollisionResult result = Collide(shapeA, shapeB);
+        spContact* contact = pairs->contacts + i;
+        spCollisionResult* result = world->results + i;
+        if (contactAsleep(contact))
+        {
+            ++i;
+            continue;
+        }
+        world->gjkIterations += contact->cache.iterations;
 
         /// check if they are colliding
-        if (result.colliding == spFalse)
+        if (result->colliding == spFalse && proxiesOverlap(world, contact))
+        {
+            /// the broadphase still sees the pair, keep the contact but without any points
+            contact->count = 0;
+            ++i;
+        }
+        else if (result->colliding == spFalse)
         {
-            /// destroy the contact
-            spContact* destroy = contact;
-            spContact* next = contact->next;
-            destroyContact(world, &destroy);
-            contact = next;
+            /// destroy the contact, the last contact and its result are moved into this slot
+            *result = world->results[pairs->count - 1];
+            spPairManagerRemoveAt(pairs, i);
         }
 
         /// they are colliding, init the contact with the collision result
         else
         {
-            initContact(&result, contact, shapeA, shapeB);
-            contact = contact->next;
+            initContact(result, contact, contact->key.shapeA, contact->key.shapeB);
+            ++i;
         }
     }
 }
@@ -307,6 +1311,16 @@ spWorldTestPoint(spWorld* world, spVector point)
     return NULL;
 }
 
+void
+spWorldQuery(spWorld* world, const spAABB* aabb, spBroadPhaseQueryCallback func, spLazyPointer context)
+{
+    NULLCHECK(world); NULLCHECK(aabb); NULLCHECK(func);
+    spBroadPhaseQuery(world->broadPhase, aabb, func, context);
+
+    StaticQueryContext query = { world, func, context };
+    spDynamicTreeQuery(&world->staticTree, aabb, (spTreeQueryFunc)staticQueryFunc, &query);
+}
+
 void 
 spWorldAddBody(spWorld* world, spBody* body)
 {
@@ -315,42 +1329,85 @@ spWorldAddBody(spWorld* world, spBody* body)
 
     foreach_shape(shape, body->shapes)
     {
-        spSapInsert(&world->sweepAndPrune, shape);
+        spWorldAddShape(world, shape);
     }
 }
 
 void 
 spWorldRemoveBody(spWorld* world, spBody* body)
 {
+    foreach_shape(shape, body->shapes)
+    {
+        spWorldRemoveShape(world, shape);
+    }
+
     SP_LINKED_LIST_REMOVE(spBody, body, world->bodyList);
     body->world = NULL;
+}
 
-    spShape* shape = body->shapes;
-    if (shape != NULL)
+void
+spWorldAddShape(spWorld* world, spShape* shape)
+{
+    NULLCHECK(world); NULLCHECK(shape);
+    insertProxy(world, shape);
+}
+
+void
+spWorldRemoveShape(spWorld* world, spShape* shape)
+{
+    NULLCHECK(world); NULLCHECK(shape);
+    removeProxy(world, shape);
+
+    /// destroy any contacts the shape is in
+    spPairManager* pairs = &world->pairs;
+    spInt i = 0;
+    while (i < pairs->count)
     {
-        while(shape)
+        spContactKey* key = &pairs->contacts[i].key;
+        if (key->shapeA == shape || key->shapeB == shape)
         {
-            if (shape->next == NULL)
-            {
-                break;
-            }
-            else
-            {
-                shape = shape->next;
-            }
+            /// whatever the shape was holding up has to notice it is gone
+            wake(key->shapeA->body);
+            wake(key->shapeB->body);
+            spPairManagerRemoveAt(pairs, i);
+        }
+        else
+        {
+            ++i;
         }
     }
+}
+
+void
+spWorldMoveStaticBody(spWorld* world, spBody* body)
+{
+    NULLCHECK(world); NULLCHECK(body);
+    spAssert(body->type == SP_BODY_STATIC, "the body is not static!");
+
+    StaticPairContext pairs;
+    pairs.world = world;
+
+    foreach_shape(shape, body->shapes)
+    {
+        if (updateFatAABB(world, shape) == spFalse) continue;
+
+        spDynamicTreeMoveProxy(&world->staticTree, shape->proxyId, &shape->aabb);
+
+        /// find the dynamic and kinematic shapes the new fat box overlaps
+        pairs.shape = shape;
+        spBroadPhaseQuery(world->broadPhase, &shape->aabb, (spBroadPhaseQueryCallback)broadPhasePairFunc, &pairs);
+    }
+    updateBodyAABB(body);
 
-    while (shape)
+    /// wake the bodies resting on it
+    foreach_contact(contact, world->pairs)
     {
-        spSapRemove(&world->sweepAndPrune, shape);
-        if (shape->prev == NULL)
+        if (contact->key.shapeA->body == body || contact->key.shapeB->body == body)
         {
-            break;
+            wake(contact->key.shapeA->body);
+            wake(contact->key.shapeB->body);
         }
-        shape = shape->prev;
     }
-    int x = 0;
 }
 
 void 
@@ -358,6 +1415,8 @@ spWorldAddConstraint(spWorld* world, spConstraint* constraint)
 {
     SP_LINKED_LIST_PREPEND(spConstraint, constraint, world->jointList);
     constraint->world = world;
+    wake(constraint->bodyA);
+    wake(constraint->bodyB);
 }
 
 void 
@@ -365,6 +1424,8 @@ spWorldRemoveConstraint(spWorld* world, spConstraint** constraint)
 {
     spConstraint* c = *constraint;
     SP_LINKED_LIST_REMOVE(spConstraint, c, world->jointList);
+    wake(c->bodyA);
+    wake(c->bodyB);
 }
 
 spConstraint* 
@@ -374,9 +1435,15 @@ spWorldGetJointList(spWorld* world)
 }
 
 spContact* 
-spWorldGetContactList(spWorld* world)
+spWorldGetContacts(spWorld* world)
+{
+    return spPairManagerGetContacts(&world->pairs);
+}
+
+spInt 
+spWorldGetContactCount(spWorld* world)
 {
-    return world->contactList;
+    return spPairManagerGetCount(&world->pairs);
 }
 
 spBody* 
@@ -397,6 +1464,66 @@ spWorldGetIterations(spWorld* world)
     return world->iterations;
 }
 
+spBroadPhaseType
+spWorldGetBroadPhase(spWorld* world)
+{
+    return world->broadPhase->type;
+}
+
+spBroadPhase*
+spWorldGetBroadPhaseObject(spWorld* world)
+{
+    return world->broadPhase;
+}
+
+spFloat
+spWorldGetGridCellSize(spWorld* world)
+{
+    return world->gridCellSize;
+}
+
+spFloat
+spWorldGetAABBMargin(spWorld* world)
+{
+    return world->aabbMargin;
+}
+
+spInt
+spWorldGetGJKIterations(spWorld* world)
+{
+    return world->gjkIterations;
+}
+
+spBool
+spWorldGetSleeping(spWorld* world)
+{
+    return world->sleeping;
+}
+
+spBool
+spWorldGetSpeculativeContacts(spWorld* world)
+{
+    return world->speculative;
+}
+
+spBool
+spWorldGetPolygonSAT(spWorld* world)
+{
+    return world->polygonSAT;
+}
+
+spBool
+spWorldGetSIMD(spWorld* world)
+{
+    return world->simd;
+}
+
+spInt
+spWorldGetThreadCount(spWorld* world)
+{
+    return world->threadPool ? spThreadPoolGetThreadCount(world->threadPool) : 1;
+}
+
 void 
 spWorldSetGravity(spWorld* world, spVector gravity)
 {
@@ -407,4 +1534,116 @@ void
 spWorldSetIterations(spWorld* world, spInt iterations)
 {
     world->iterations = iterations;
-}
\ No newline at end of file
+}
+
+void
+spWorldSetBroadPhase(spWorld* world, spBroadPhaseType type)
+{
+    if (world->broadPhase->type == type) return;
+
+    spBroadPhase* broadPhase = type == SP_BROADPHASE_GRID ? spGridBroadPhaseNew(world->gridCellSize) : spBroadPhaseNew(type);
+    spWorldSetBroadPhaseObject(world, broadPhase);
+}
+
+void
+spWorldSetBroadPhaseObject(spWorld* world, spBroadPhase* broadPhase)
+{
+    NULLCHECK(broadPhase);
+
+    /// move every shape from the old broadphase into the new one, static shapes stay in the static tree
+    foreach_body(body, world->bodyList)
+    {
+        if (body->type == SP_BODY_STATIC) continue;
+
+        foreach_shape(shape, body->shapes)
+        {
+            removeProxy(world, shape);
+        }
+    }
+
+    spBroadPhaseFree(&world->broadPhase);
+    world->broadPhase = broadPhase;
+
+    foreach_body(body, world->bodyList)
+    {
+        if (body->type == SP_BODY_STATIC) continue;
+
+        foreach_shape(shape, body->shapes)
+        {
+            insertProxy(world, shape);
+        }
+    }
+}
+
+void
+spWorldSetGridCellSize(spWorld* world, spFloat cellSize)
+{
+    world->gridCellSize = cellSize;
+    if (world->broadPhase->type == SP_BROADPHASE_GRID)
+    {
+        spSpatialHashSetCellSize(&spBroadPhaseCastGrid(world->broadPhase)->grid, cellSize);
+    }
+}
+
+void
+spWorldSetAABBMargin(spWorld* world, spFloat margin)
+{
+    spAssert(margin >= 0.0f, "the margin cannot be negative!");
+    world->aabbMargin = margin;
+}
+
+void
+spWorldSetSleeping(spWorld* world, spBool sleeping)
+{
+    world->sleeping = sleeping;
+    if (sleeping) return;
+
+    foreach_body(body, world->bodyList)
+    {
+        wake(body);
+    }
+}
+
+void
+spWorldSetSpeculativeContacts(spWorld* world, spBool speculative)
+{
+    world->speculative = speculative;
+    if (speculative) return;
+
+    /// pairs go back to only making contacts while touching
+    foreach_contact(contact, world->pairs)
+    {
+        contact->cache.margin = 0.0f;
+    }
+}
+
+void
+spWorldSetPolygonSAT(spWorld* world, spBool sat)
+{
+    world->polygonSAT = sat;
+}
+
+void
+spWorldSetSIMD(spWorld* world, spBool simd)
+{
+    world->simd = simd && spContactSolverHasSIMD();
+}
+
+void
+spWorldSetThreadCount(spWorld* world, spInt threadCount)
+{
+    spAssert(threadCount >= 0, "the thread count cannot be negative!");
+    if (threadCount == 0) threadCount = spGetProcessorCount();
+    if (threadCount == spWorldGetThreadCount(world)) return;
+
+    if (world->threadPool)
+    {
+        spThreadPoolFree(&world->threadPool);
+    }
+
+    /// a single thread runs everything on the calling thread without a pool
+    if (threadCount > 1)
+    {
+        world->threadPool = spThreadPoolNew(threadCount);
+    }
+}